@@ -0,0 +1,295 @@
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "i2c_identify.h"
+
+static const char *TAG = "I2C_ID";
+
+// Bump whenever the device table or i2c_topology_t changes, so stale caches are ignored
+#define TOPOLOGY_CACHE_VERSION      2
+
+#define ID_MAX_CHECKS               2
+
+/**
+ * @brief One fingerprint read: (register & mask) must equal value
+ */
+typedef struct
+{
+    uint8_t reg;
+    uint8_t mask;
+    uint8_t value;
+} id_check_t;
+
+/**
+ * @brief A known device: address range and fingerprint, no checks for address-only matches
+ *
+ * verify, when set, runs after the register checks for fingerprints that take more than one
+ * masked read to tell apart from another device.
+ */
+typedef struct
+{
+    i2c_dev_type_t type;
+    uint8_t first_address;
+    uint8_t last_address;
+    uint8_t checks_len;
+    id_check_t checks[ID_MAX_CHECKS];
+    bool (*verify)(i2c_master_dev_handle_t dev);
+} id_entry_t;
+
+static esp_err_t read_regs(i2c_master_dev_handle_t dev, uint8_t reg, uint8_t *data, size_t len)
+{
+    return i2c_master_transmit_receive(dev, &reg, 1, data, len, I2C_IDENTIFY_TIMEOUT_MS);
+}
+
+/*
+ * The DS3231 register pointer wraps from 0x12 to 0x00, so reading on past the temperature LSB
+ * returns the time registers again. A DS1307 returns its RAM at 0x13-0x18 instead, which would have
+ * to hold its own current time; zeroed RAM never does, since date and month read at least 1.
+ */
+static bool ds3231_pointer_wraps(i2c_master_dev_handle_t dev)
+{
+    uint8_t wrapped[8], time[7];
+
+    // A minute rollover between the two reads gets a second attempt
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (read_regs(dev, 0x12, wrapped, sizeof(wrapped)) != ESP_OK || read_regs(dev, 0x00, time, sizeof(time)) != ESP_OK)
+            return false;
+        // Minutes to year: the seconds may tick between the reads
+        if (memcmp(&wrapped[2], &time[1], 6) == 0)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Entries sharing an address are tried in order, so the stronger fingerprints go first:
+ * a WHO_AM_I register before register defaults, and both before address-only entries.
+ */
+static const id_entry_t id_table[] = {
+    // WHO_AM_I (0x75) holds the address bits 6..1 whatever the AD0 pin
+    {I2C_DEV_MPU6050, 0x68, 0x69, 1, {{0x75, 0x7e, 0x68}}},
+    // Status bits 6..4 and the temperature LSB bits 5..0 always read as zero, and the register
+    // pointer wraps after 0x12; the first two alone also match a DS1307 with zeroed RAM
+    {I2C_DEV_DS3231, 0x68, 0x68, 2, {{0x0f, 0x70, 0x00}, {0x12, 0x3f, 0x00}}, ds3231_pointer_wraps},
+    // Control register bits 6, 5, 3 and 2 always read as zero
+    {I2C_DEV_DS1307, 0x68, 0x68, 1, {{0x07, 0x6c, 0x00}}},
+    // Chip id register
+    {I2C_DEV_BMP180, 0x77, 0x77, 1, {{0xd0, 0xff, 0x55}}},
+    {I2C_DEV_BMP280, 0x76, 0x77, 1, {{0xd0, 0xff, 0x58}}},
+    {I2C_DEV_BME280, 0x76, 0x77, 1, {{0xd0, 0xff, 0x60}}},
+    // No identification registers: matched by address only
+    {I2C_DEV_SSD1306, 0x3c, 0x3d, 0, {{0}}},
+    {I2C_DEV_PCF8574, 0x20, 0x27, 0, {{0}}},
+    {I2C_DEV_PCF8574, 0x38, 0x3f, 0, {{0}}},
+    {I2C_DEV_AT24CXX, 0x50, 0x57, 0, {{0}}},
+};
+
+static const char *const type_names[I2C_DEV_TYPE_MAX] = {
+    [I2C_DEV_UNKNOWN] = "?",
+    [I2C_DEV_PCF8574] = "PCF8574",
+    [I2C_DEV_SSD1306] = "SSD1306",
+    [I2C_DEV_AT24CXX] = "AT24Cxx",
+    [I2C_DEV_DS3231] = "DS3231",
+    [I2C_DEV_DS1307] = "DS1307",
+    [I2C_DEV_MPU6050] = "MPU6050",
+    [I2C_DEV_BMP180] = "BMP180",
+    [I2C_DEV_BMP280] = "BMP280",
+    [I2C_DEV_BME280] = "BME280",
+};
+
+/**
+ * @brief Layout of the NVS blob
+ */
+typedef struct
+{
+    uint32_t version;
+    i2c_topology_t topology;
+} topology_cache_t;
+
+const char *i2c_dev_type_name(i2c_dev_type_t type)
+{
+    return (type > I2C_DEV_UNKNOWN && type < I2C_DEV_TYPE_MAX) ? type_names[type] : type_names[I2C_DEV_UNKNOWN];
+}
+
+static bool entry_matches(i2c_master_dev_handle_t dev, const id_entry_t *entry)
+{
+    for (int i = 0; i < entry->checks_len; i++)
+    {
+        const id_check_t *check = &entry->checks[i];
+        uint8_t value;
+        if (read_regs(dev, check->reg, &value, 1) != ESP_OK)
+            return false;
+        if ((value & check->mask) != check->value)
+            return false;
+    }
+    return !entry->verify || entry->verify(dev);
+}
+
+esp_err_t i2c_identify_address(i2c_master_bus_handle_t bus, uint8_t address, i2c_topology_entry_t *entry)
+{
+    if (!bus || !entry || address > 0x7f)
+        return ESP_ERR_INVALID_ARG;
+
+    entry->address = address;
+    entry->type = I2C_DEV_UNKNOWN;
+    entry->match = I2C_MATCH_NONE;
+
+    i2c_master_dev_handle_t dev = NULL;
+    const id_entry_t *fallback = NULL;
+
+    for (size_t i = 0; i < sizeof(id_table) / sizeof(id_table[0]); i++)
+    {
+        const id_entry_t *id = &id_table[i];
+        if (address < id->first_address || address > id->last_address)
+            continue;
+
+        if (id->checks_len == 0)
+        {
+            if (!fallback) fallback = id;
+            continue;
+        }
+
+        // The device is only added to the bus when some entry needs register reads
+        if (!dev)
+        {
+            i2c_device_config_t dev_config = {
+                .dev_addr_length = I2C_ADDR_BIT_7,
+                .device_address = address,
+                .scl_speed_hz = I2C_IDENTIFY_SCL_SPEED_HZ,
+            };
+            esp_err_t ret = i2c_master_bus_add_device(bus, &dev_config, &dev);
+            if (ret != ESP_OK)
+                return ret;
+        }
+
+        if (entry_matches(dev, id))
+        {
+            entry->type = id->type;
+            entry->match = I2C_MATCH_FINGERPRINT;
+            break;
+        }
+    }
+
+    if (dev)
+        i2c_master_bus_rm_device(dev);
+
+    if (entry->match == I2C_MATCH_NONE && fallback)
+    {
+        entry->type = fallback->type;
+        entry->match = I2C_MATCH_ADDRESS;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_identify(i2c_master_bus_handle_t bus, const i2c_scan_result_t *scan, i2c_topology_t *topology)
+{
+    if (!bus || !scan || !topology)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(topology, 0, sizeof(*topology));
+    topology->addresses = scan->found;
+
+    for (int address = 0; address < 128; address++)
+    {
+        if (!i2c_scan_bitmap_test(&scan->found, address))
+            continue;
+        if (topology->count == I2C_TOPOLOGY_MAX_DEVICES)
+        {
+            ESP_LOGW(TAG, "More than %d devices, 0x%02X and above not identified", I2C_TOPOLOGY_MAX_DEVICES, address);
+            break;
+        }
+
+        i2c_topology_entry_t *entry = &topology->devices[topology->count];
+        esp_err_t ret = i2c_identify_address(bus, address, entry);
+        if (ret != ESP_OK)
+            return ret;
+        topology->count++;
+
+        ESP_LOGD(TAG, "0x%02X: %s (%s)", address, i2c_dev_type_name(entry->type),
+                 entry->match == I2C_MATCH_FINGERPRINT ? "fingerprint" : "address");
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_topology_load(i2c_topology_t *topology)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(I2C_TOPOLOGY_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret != ESP_OK)
+        return ret;
+
+    topology_cache_t cache;
+    size_t size = sizeof(cache);
+    ret = nvs_get_blob(nvs, I2C_TOPOLOGY_NVS_KEY, &cache, &size);
+    nvs_close(nvs);
+    if (ret != ESP_OK)
+        return ret;
+
+    if (size != sizeof(cache) || cache.version != TOPOLOGY_CACHE_VERSION
+        || cache.topology.count > I2C_TOPOLOGY_MAX_DEVICES)
+        return ESP_ERR_INVALID_VERSION;
+
+    *topology = cache.topology;
+    return ESP_OK;
+}
+
+esp_err_t i2c_topology_save(const i2c_topology_t *topology)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(I2C_TOPOLOGY_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK)
+        return ret;
+
+    topology_cache_t cache = {
+        .version = TOPOLOGY_CACHE_VERSION,
+        .topology = *topology,
+    };
+    ret = nvs_set_blob(nvs, I2C_TOPOLOGY_NVS_KEY, &cache, sizeof(cache));
+    if (ret == ESP_OK)
+        ret = nvs_commit(nvs);
+    nvs_close(nvs);
+    return ret;
+}
+
+esp_err_t i2c_identify_cached(i2c_master_bus_handle_t bus, const i2c_scan_result_t *scan,
+                              i2c_topology_t *topology, bool *from_cache)
+{
+    if (!bus || !scan || !topology)
+        return ESP_ERR_INVALID_ARG;
+
+    if (from_cache) *from_cache = false;
+
+    // Same addresses as when the cache was written: trust it and skip the register reads
+    if (i2c_topology_load(topology) == ESP_OK
+        && memcmp(&topology->addresses, &scan->found, sizeof(scan->found)) == 0)
+    {
+        if (from_cache) *from_cache = true;
+        return ESP_OK;
+    }
+
+    esp_err_t ret = i2c_identify(bus, scan, topology);
+    if (ret != ESP_OK)
+        return ret;
+
+    ret = i2c_topology_save(topology);
+    if (ret != ESP_OK)
+        ESP_LOGW(TAG, "Topology not cached: %s", esp_err_to_name(ret));
+    return ESP_OK;
+}
+
+esp_err_t i2c_topology_find(const i2c_topology_t *topology, i2c_dev_type_t type, int index, uint8_t *address)
+{
+    if (!topology || !address)
+        return ESP_ERR_INVALID_ARG;
+
+    for (int i = 0; i < topology->count; i++)
+    {
+        if (topology->devices[i].type == type && index-- == 0)
+        {
+            *address = topology->devices[i].address;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
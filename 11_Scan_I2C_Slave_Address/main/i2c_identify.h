@@ -0,0 +1,143 @@
+#ifndef I2C_IDENTIFY_H
+#define I2C_IDENTIFY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "i2c_scanner.h"
+
+// Devices kept in a topology; further addresses are reported by the scan but not identified
+#define I2C_TOPOLOGY_MAX_DEVICES    16
+
+// Clock used for the fingerprint reads; every known device supports standard mode
+#define I2C_IDENTIFY_SCL_SPEED_HZ   100000
+
+// Timeout of one fingerprint read
+#define I2C_IDENTIFY_TIMEOUT_MS     10
+
+// NVS namespace and key of the cached topology
+#define I2C_TOPOLOGY_NVS_NAMESPACE  "i2c_topo"
+#define I2C_TOPOLOGY_NVS_KEY        "topology"
+
+/**
+ * @brief Device types known to the identification table
+ */
+typedef enum
+{
+    I2C_DEV_UNKNOWN = 0,
+    I2C_DEV_PCF8574,        // I/O expander, LCD 16x2 backpack
+    I2C_DEV_SSD1306,        // OLED controller
+    I2C_DEV_AT24CXX,        // EEPROM
+    I2C_DEV_DS3231,         // RTC with TCXO
+    I2C_DEV_DS1307,         // RTC
+    I2C_DEV_MPU6050,        // IMU
+    I2C_DEV_BMP180,         // Pressure sensor
+    I2C_DEV_BMP280,         // Pressure sensor
+    I2C_DEV_BME280,         // Pressure, humidity sensor
+    I2C_DEV_TYPE_MAX,
+} i2c_dev_type_t;
+
+/**
+ * @brief How a topology entry was identified
+ *
+ * FINGERPRINT entries matched register contents; ADDRESS entries only match the address
+ * range of a device without identification registers, so they are a best guess.
+ */
+typedef enum
+{
+    I2C_MATCH_NONE = 0,
+    I2C_MATCH_ADDRESS,
+    I2C_MATCH_FINGERPRINT,
+} i2c_match_t;
+
+/**
+ * @brief One device found on the bus
+ */
+typedef struct
+{
+    uint8_t address;
+    uint8_t type;           // i2c_dev_type_t
+    uint8_t match;          // i2c_match_t
+} i2c_topology_entry_t;
+
+/**
+ * @brief Devices found on one bus
+ *
+ * addresses is the scan bitmap the topology was built from; a cached topology is only
+ * valid while a new scan returns the same bitmap.
+ */
+typedef struct
+{
+    i2c_scan_bitmap_t addresses;
+    uint8_t count;
+    i2c_topology_entry_t devices[I2C_TOPOLOGY_MAX_DEVICES];
+} i2c_topology_t;
+
+/**
+ * @brief Identifies every address found by a complete scan
+ *
+ * For each address, the entries of the device table that cover it are tried in order:
+ * the first one whose register reads all match wins, else the first address-only entry.
+ *
+ * @param bus      The bus the scan ran on
+ * @param scan     Result of a scan that covered the whole range
+ * @param topology Identified devices
+ *
+ * @return
+ *   - ESP_OK on success.
+ *   - ESP_ERR_INVALID_ARG for missing arguments.
+ *   - Errors from adding the temporary device to the bus.
+ */
+esp_err_t i2c_identify(i2c_master_bus_handle_t bus, const i2c_scan_result_t *scan, i2c_topology_t *topology);
+
+/**
+ * @brief Identifies the device at one address, e.g. a module plugged in after the scan
+ *
+ * @param bus     The bus the device is on
+ * @param address Address that acknowledged a probe
+ * @param entry   Address, type and match of the device
+ */
+esp_err_t i2c_identify_address(i2c_master_bus_handle_t bus, uint8_t address, i2c_topology_entry_t *entry);
+
+/**
+ * @brief Like i2c_identify(), but reuses the topology cached in NVS while the bus is unchanged
+ *
+ * A topology built by identification is written back to NVS. NVS must be initialized.
+ *
+ * @param from_cache Set to true when the cached topology was used, may be NULL
+ */
+esp_err_t i2c_identify_cached(i2c_master_bus_handle_t bus, const i2c_scan_result_t *scan,
+                              i2c_topology_t *topology, bool *from_cache);
+
+/**
+ * @brief Loads the topology cached in NVS
+ *
+ * @return ESP_OK, ESP_ERR_NVS_NOT_FOUND if there is none, ESP_ERR_INVALID_VERSION if it was
+ *         written by an incompatible version of the table, or other NVS errors.
+ */
+esp_err_t i2c_topology_load(i2c_topology_t *topology);
+
+/**
+ * @brief Stores the topology in NVS
+ */
+esp_err_t i2c_topology_save(const i2c_topology_t *topology);
+
+/**
+ * @brief Finds the n-th device of a type, so a driver can attach to whatever address it uses
+ *
+ * @param topology Identified devices
+ * @param type     Wanted device type
+ * @param index    0 for the first device of that type, 1 for the second, ...
+ * @param address  Address of the device
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the bus has no such device
+ */
+esp_err_t i2c_topology_find(const i2c_topology_t *topology, i2c_dev_type_t type, int index, uint8_t *address);
+
+/**
+ * @brief Name of a device type, "?" for unknown devices
+ */
+const char *i2c_dev_type_name(i2c_dev_type_t type);
+
+#endif /* I2C_IDENTIFY_H */
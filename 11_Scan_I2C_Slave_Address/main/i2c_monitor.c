@@ -0,0 +1,188 @@
+#include <string.h>
+#include "esp_log.h"
+#include "i2c_monitor.h"
+
+static const char *TAG = "I2C_MON";
+
+static int find_device(const i2c_topology_t *topology, uint8_t address)
+{
+    for (int i = 0; i < topology->count; i++)
+    {
+        if (topology->devices[i].address == address) return i;
+    }
+    return -1;
+}
+
+static void publish(i2c_monitor_t *monitor, i2c_monitor_event_type_t type, const i2c_topology_entry_t *device)
+{
+    ESP_LOGI(TAG, "0x%02X %s: %s", device->address, type == I2C_MONITOR_ATTACHED ? "attached" : "detached",
+             i2c_dev_type_name(device->type));
+
+    if (monitor->config.persist)
+    {
+        esp_err_t ret = i2c_topology_save(&monitor->topology);
+        if (ret != ESP_OK) ESP_LOGW(TAG, "Topology not cached: %s", esp_err_to_name(ret));
+    }
+
+    if (monitor->callback)
+    {
+        i2c_monitor_event_t event = {.type = type, .device = *device};
+        monitor->callback(&event, monitor->callback_arg);
+    }
+}
+
+static void attach(i2c_monitor_t *monitor, uint8_t address)
+{
+    i2c_topology_entry_t device;
+    if (i2c_identify_address(monitor->bus, address, &device) != ESP_OK)
+    {
+        // Try again on the next pass
+        return;
+    }
+
+    i2c_topology_t *topology = &monitor->topology;
+    portENTER_CRITICAL(&monitor->lock);
+    i2c_scan_bitmap_set(&topology->addresses, address);
+    if (topology->count < I2C_TOPOLOGY_MAX_DEVICES)
+    {
+        // Keep the devices sorted by address, as i2c_identify() builds them
+        int i = topology->count;
+        while (i > 0 && topology->devices[i - 1].address > address)
+        {
+            topology->devices[i] = topology->devices[i - 1];
+            monitor->misses[i] = monitor->misses[i - 1];
+            i--;
+        }
+        topology->devices[i] = device;
+        monitor->misses[i] = 0;
+        topology->count++;
+    }
+    portEXIT_CRITICAL(&monitor->lock);
+
+    publish(monitor, I2C_MONITOR_ATTACHED, &device);
+}
+
+static void detach(i2c_monitor_t *monitor, uint8_t address, int index)
+{
+    i2c_topology_t *topology = &monitor->topology;
+    i2c_topology_entry_t device = {.address = address};
+
+    portENTER_CRITICAL(&monitor->lock);
+    i2c_scan_bitmap_clear(&topology->addresses, address);
+    if (index >= 0)
+    {
+        device = topology->devices[index];
+        for (int i = index; i < topology->count - 1; i++)
+        {
+            topology->devices[i] = topology->devices[i + 1];
+            monitor->misses[i] = monitor->misses[i + 1];
+        }
+        topology->count--;
+    }
+    portEXIT_CRITICAL(&monitor->lock);
+
+    publish(monitor, I2C_MONITOR_DETACHED, &device);
+}
+
+static void check_address(i2c_monitor_t *monitor, uint8_t address)
+{
+    esp_err_t ret = i2c_master_probe(monitor->bus, address, monitor->config.probe_timeout_ms);
+    bool known = i2c_scan_bitmap_test(&monitor->topology.addresses, address);
+    int index = find_device(&monitor->topology, address);
+
+    if (ret == ESP_OK)
+    {
+        if (index >= 0) monitor->misses[index] = 0;
+        if (!known) attach(monitor, address);
+    }
+    else if (ret == ESP_ERR_NOT_FOUND)
+    {
+        if (!known) return;
+        if (index >= 0 && ++monitor->misses[index] < monitor->config.detach_misses) return;
+        detach(monitor, address, index);
+    }
+    else
+    {
+        // A bus fault says nothing about this address; leave it for the next pass
+        ESP_LOGD(TAG, "Probe of 0x%02X failed: %s", address, esp_err_to_name(ret));
+    }
+}
+
+static void monitor_task(void *arg)
+{
+    i2c_monitor_t *monitor = (i2c_monitor_t *)arg;
+    const i2c_monitor_config_t *config = &monitor->config;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (!monitor->stop)
+    {
+        for (int i = 0; i < config->addresses_per_tick; i++)
+        {
+            check_address(monitor, monitor->next_address);
+            if (monitor->next_address++ == config->last_address)
+            {
+                monitor->next_address = config->first_address;
+                monitor->passes++;
+            }
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(config->tick_ms));
+    }
+
+    monitor->task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t i2c_monitor_start(i2c_monitor_t *monitor, i2c_master_bus_handle_t bus, const i2c_topology_t *topology,
+                            const i2c_monitor_config_t *config, i2c_monitor_cb_t callback, void *arg)
+{
+    static const i2c_monitor_config_t default_config = I2C_MONITOR_CONFIG_DEFAULT();
+
+    if (!config) config = &default_config;
+    if (!monitor || !bus || !topology || config->first_address > config->last_address
+        || config->last_address > 0x7f || config->addresses_per_tick == 0 || config->tick_ms == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->bus = bus;
+    monitor->config = *config;
+    monitor->topology = *topology;
+    monitor->next_address = config->first_address;
+    monitor->callback = callback;
+    monitor->callback_arg = arg;
+    portMUX_INITIALIZE(&monitor->lock);
+
+    if (xTaskCreate(monitor_task, "i2c_monitor", config->task_stack, monitor, config->task_priority,
+                    &monitor->task) != pdPASS)
+    {
+        monitor->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t pass_ms = (config->last_address - config->first_address + config->addresses_per_tick)
+                       / config->addresses_per_tick * config->tick_ms;
+    ESP_LOGI(TAG, "Watching 0x%02X-0x%02X, %d addresses every %lu ms (full pass every %lu ms)",
+             config->first_address, config->last_address, config->addresses_per_tick,
+             (unsigned long)config->tick_ms, (unsigned long)pass_ms);
+    return ESP_OK;
+}
+
+esp_err_t i2c_monitor_stop(i2c_monitor_t *monitor)
+{
+    if (!monitor)
+        return ESP_ERR_INVALID_ARG;
+    if (!monitor->task)
+        return ESP_ERR_INVALID_STATE;
+
+    // The task finishes its current tick and clears the handle on its way out
+    monitor->stop = true;
+    while (monitor->task)
+        vTaskDelay(pdMS_TO_TICKS(monitor->config.tick_ms));
+    return ESP_OK;
+}
+
+void i2c_monitor_get_topology(i2c_monitor_t *monitor, i2c_topology_t *topology)
+{
+    portENTER_CRITICAL(&monitor->lock);
+    *topology = monitor->topology;
+    portEXIT_CRITICAL(&monitor->lock);
+}
@@ -0,0 +1,118 @@
+#ifndef I2C_MONITOR_H
+#define I2C_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "i2c_identify.h"
+
+/**
+ * @brief Kind of topology change
+ */
+typedef enum
+{
+    I2C_MONITOR_ATTACHED,
+    I2C_MONITOR_DETACHED,
+} i2c_monitor_event_type_t;
+
+/**
+ * @brief One topology change
+ *
+ * For a detach, device is the entry that was removed from the topology.
+ */
+typedef struct
+{
+    i2c_monitor_event_type_t type;
+    i2c_topology_entry_t device;
+} i2c_monitor_event_t;
+
+/**
+ * @brief Called from the monitor task for every change, after the topology was updated
+ */
+typedef void (*i2c_monitor_cb_t)(const i2c_monitor_event_t *event, void *arg);
+
+/**
+ * @brief Monitor settings
+ *
+ * Probing addresses_per_tick addresses every tick_ms spreads a full pass over the range across
+ * several ticks, so the bus is never held for more than a few probes at a time. A device is only
+ * reported detached after detach_misses consecutive NACKs, so a device busy with an internal
+ * operation (an EEPROM write cycle NACKs its address for up to 5 ms) is not dropped.
+ */
+typedef struct
+{
+    uint8_t first_address;
+    uint8_t last_address;
+    uint8_t addresses_per_tick;
+    uint32_t tick_ms;
+    uint32_t probe_timeout_ms;
+    uint8_t detach_misses;
+    bool persist;                // Save the topology to NVS after every change
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} i2c_monitor_config_t;
+
+#define I2C_MONITOR_CONFIG_DEFAULT() {              \
+    .first_address = I2C_SCAN_FIRST_ADDRESS,        \
+    .last_address = I2C_SCAN_LAST_ADDRESS,          \
+    .addresses_per_tick = 4,                        \
+    .tick_ms = 100,                                 \
+    .probe_timeout_ms = 10,                         \
+    .detach_misses = 2,                             \
+    .persist = true,                                \
+    .task_priority = 1,                             \
+    .task_stack = 3072,                             \
+}
+
+/**
+ * @brief Hot-plug monitor of one bus
+ *
+ * The topology is owned by the monitor task while it runs; read it with i2c_monitor_get_topology().
+ */
+typedef struct
+{
+    i2c_master_bus_handle_t bus;
+    i2c_monitor_config_t config;
+    i2c_topology_t topology;
+    uint8_t misses[I2C_TOPOLOGY_MAX_DEVICES];
+    uint8_t next_address;
+    uint32_t passes;             // Complete passes over the address range
+    i2c_monitor_cb_t callback;
+    void *callback_arg;
+    TaskHandle_t task;
+    volatile bool stop;
+    portMUX_TYPE lock;
+} i2c_monitor_t;
+
+/**
+ * @brief Starts the monitor task
+ *
+ * @param monitor  Monitor state, must stay valid until i2c_monitor_stop()
+ * @param bus      The bus to watch; other devices may keep using it, the driver serializes transfers
+ * @param topology Known devices, usually from i2c_identify_cached()
+ * @param config   Monitor settings, NULL for I2C_MONITOR_CONFIG_DEFAULT()
+ * @param callback Called for every attach and detach, may be NULL
+ * @param arg      User argument passed to the callback
+ *
+ * @return
+ *   - ESP_OK on success.
+ *   - ESP_ERR_INVALID_ARG for missing arguments or a bad address range.
+ *   - ESP_ERR_NO_MEM if the task could not be created.
+ */
+esp_err_t i2c_monitor_start(i2c_monitor_t *monitor, i2c_master_bus_handle_t bus, const i2c_topology_t *topology,
+                            const i2c_monitor_config_t *config, i2c_monitor_cb_t callback, void *arg);
+
+/**
+ * @brief Stops the monitor task and waits until it has exited
+ */
+esp_err_t i2c_monitor_stop(i2c_monitor_t *monitor);
+
+/**
+ * @brief Copies the current topology
+ */
+void i2c_monitor_get_topology(i2c_monitor_t *monitor, i2c_topology_t *topology);
+
+#endif /* I2C_MONITOR_H */
@@ -0,0 +1,147 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2c_scanner.h"
+
+static const char *TAG = "I2C_SCAN";
+
+esp_err_t i2c_scan(i2c_master_bus_handle_t bus, const i2c_scan_config_t *config, i2c_scan_result_t *result)
+{
+    static const i2c_scan_config_t default_config = I2C_SCAN_CONFIG_DEFAULT();
+
+    if (!config) config = &default_config;
+    if (!bus || !result || config->first_address > config->last_address || config->last_address > 0x7f)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(result, 0, sizeof(*result));
+
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = config->deadline_ms ? start + config->deadline_ms * 1000LL : INT64_MAX;
+    uint8_t consecutive_faults = 0;
+    bool bus_reset = false;
+    esp_err_t ret = ESP_OK;
+
+    int address = config->first_address;
+    while (address <= config->last_address)
+    {
+        if (esp_timer_get_time() >= deadline)
+        {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+
+        esp_err_t probe = i2c_master_probe(bus, address, config->probe_timeout_ms);
+        if (probe == ESP_OK)
+        {
+            i2c_scan_bitmap_set(&result->found, address);
+            result->count++;
+        }
+        else if (probe != ESP_ERR_NOT_FOUND)
+        {
+            // Timeout or bus error: the bus, not this address, is at fault
+            result->bus_faults++;
+            if (++consecutive_faults >= config->max_bus_faults)
+            {
+                if (bus_reset)
+                {
+                    ESP_LOGW(TAG, "Bus fault at 0x%02X persists after a bus reset, scan aborted", address);
+                    ret = ESP_ERR_INVALID_STATE;
+                    break;
+                }
+                // One attempt to free a stuck SDA (9 SCL pulses and a STOP), then probe this address again
+                ESP_LOGW(TAG, "Bus fault at 0x%02X (%s), resetting the bus", address, esp_err_to_name(probe));
+                bus_reset = true;
+                consecutive_faults = 0;
+                if (i2c_master_bus_reset(bus) != ESP_OK)
+                {
+                    ret = ESP_ERR_INVALID_STATE;
+                    break;
+                }
+                continue;
+            }
+        }
+        else
+        {
+            consecutive_faults = 0;
+        }
+        address++;
+    }
+
+    result->next_address = address;
+    result->elapsed_us = esp_timer_get_time() - start;
+    return ret;
+}
+
+/**
+ * @brief Work of one scan task
+ */
+typedef struct
+{
+    const i2c_scan_config_t *config;
+    i2c_scan_bus_result_t *out;
+    TaskHandle_t waiter;
+} scan_job_t;
+
+static void scan_task(void *arg)
+{
+    scan_job_t *job = (scan_job_t *)arg;
+
+    job->out->status = i2c_scan(job->out->bus, job->config, &job->out->result);
+    xTaskNotifyGive(job->waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t i2c_scan_parallel(const i2c_master_bus_handle_t *buses, size_t count, const i2c_scan_config_t *config,
+                            i2c_scan_multi_result_t *result)
+{
+    if (!buses || !result || count == 0 || count > I2C_SCAN_MAX_BUSES)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(result, 0, sizeof(*result));
+    result->count = count;
+
+    scan_job_t jobs[I2C_SCAN_MAX_BUSES];
+    bool spawned[I2C_SCAN_MAX_BUSES] = {false};
+    int64_t start = esp_timer_get_time();
+
+    // Discard a notification left over from an earlier call, then start one task per bus
+    ulTaskNotifyTake(pdTRUE, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        result->buses[i].bus = buses[i];
+        jobs[i] = (scan_job_t){.config = config, .out = &result->buses[i], .waiter = xTaskGetCurrentTaskHandle()};
+        spawned[i] = xTaskCreate(scan_task, "i2c_scan", I2C_SCAN_TASK_STACK, &jobs[i], I2C_SCAN_TASK_PRIORITY,
+                                 NULL) == pdPASS;
+    }
+
+    size_t pending = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (spawned[i])
+        {
+            pending++;
+            continue;
+        }
+        ESP_LOGW(TAG, "No task for bus %u, scanning it inline", (unsigned)i);
+        result->buses[i].status = i2c_scan(buses[i], config, &result->buses[i].result);
+    }
+
+    // jobs lives on this stack, so every task must have finished before returning
+    for (; pending > 0; pending--)
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+    result->elapsed_us = esp_timer_get_time() - start;
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < count; i++)
+    {
+        const i2c_scan_bus_result_t *bus = &result->buses[i];
+        result->devices += bus->result.count;
+        result->sum_us += bus->result.elapsed_us;
+        if (ret == ESP_OK && bus->status != ESP_OK)
+            ret = bus->status;
+    }
+    return ret;
+}
@@ -0,0 +1,141 @@
+#ifndef I2C_SCANNER_H
+#define I2C_SCANNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+// Valid 7-bit addresses; 0x00-0x07 and 0x78-0x7F are reserved by the I2C specification
+#define I2C_SCAN_FIRST_ADDRESS      0x08
+#define I2C_SCAN_LAST_ADDRESS       0x77
+
+// Buses scanned at once by i2c_scan_parallel(), one per I2C controller of the ESP32
+#define I2C_SCAN_MAX_BUSES          2
+
+// Worker tasks of i2c_scan_parallel(); they only wait on the bus, so the stack stays small
+#define I2C_SCAN_TASK_STACK         3072
+#define I2C_SCAN_TASK_PRIORITY      5
+
+/**
+ * @brief Set of 7-bit addresses, one bit per address
+ */
+typedef struct
+{
+    uint32_t bits[4];
+} i2c_scan_bitmap_t;
+
+/**
+ * @brief Scan limits
+ *
+ * A device that answers does so within a few bit times; the probe timeout only bounds how long
+ * a bus fault (SCL held low, SDA stuck) can block one probe. The deadline bounds the whole scan.
+ */
+typedef struct
+{
+    uint8_t first_address;
+    uint8_t last_address;
+    uint32_t probe_timeout_ms;   // Per address
+    uint32_t deadline_ms;        // Whole scan, 0 for none
+    uint8_t max_bus_faults;      // Consecutive bus faults (after a bus reset) that abort the scan
+} i2c_scan_config_t;
+
+#define I2C_SCAN_CONFIG_DEFAULT() {                 \
+    .first_address = I2C_SCAN_FIRST_ADDRESS,        \
+    .last_address = I2C_SCAN_LAST_ADDRESS,          \
+    .probe_timeout_ms = 10,                         \
+    .deadline_ms = 200,                             \
+    .max_bus_faults = 3,                            \
+}
+
+/**
+ * @brief Outcome of a scan
+ *
+ * found holds every address that acknowledged. When the scan stops early, next_address
+ * is the first address that was not probed, so a later call can resume from there.
+ */
+typedef struct
+{
+    i2c_scan_bitmap_t found;
+    uint8_t count;
+    uint8_t next_address;
+    uint8_t bus_faults;
+    int64_t elapsed_us;
+} i2c_scan_result_t;
+
+static inline bool i2c_scan_bitmap_test(const i2c_scan_bitmap_t *bitmap, uint8_t address)
+{
+    return address < 128 && (bitmap->bits[address >> 5] & (1u << (address & 31)));
+}
+
+static inline void i2c_scan_bitmap_set(i2c_scan_bitmap_t *bitmap, uint8_t address)
+{
+    if (address < 128) bitmap->bits[address >> 5] |= 1u << (address & 31);
+}
+
+static inline void i2c_scan_bitmap_clear(i2c_scan_bitmap_t *bitmap, uint8_t address)
+{
+    if (address < 128) bitmap->bits[address >> 5] &= ~(1u << (address & 31));
+}
+
+/**
+ * @brief Outcome of one bus in a parallel scan
+ */
+typedef struct
+{
+    i2c_master_bus_handle_t bus;
+    esp_err_t status;            // What i2c_scan() returned for this bus
+    i2c_scan_result_t result;    // result.elapsed_us is the scan time of this bus
+} i2c_scan_bus_result_t;
+
+/**
+ * @brief Merged outcome of a parallel scan
+ *
+ * elapsed_us is the wall time of the whole call, bounded by the slowest bus; sum_us adds
+ * up the per-bus times, i.e. what scanning the buses one after the other would have taken.
+ */
+typedef struct
+{
+    size_t count;
+    i2c_scan_bus_result_t buses[I2C_SCAN_MAX_BUSES];
+    uint16_t devices;            // Found on all buses
+    int64_t elapsed_us;
+    int64_t sum_us;
+} i2c_scan_multi_result_t;
+
+/**
+ * @brief Probes every address of the configured range with i2c_master_probe()
+ *
+ * @param bus    An initialized I2C master bus handle
+ * @param config Scan limits, NULL for I2C_SCAN_CONFIG_DEFAULT()
+ * @param result Found addresses and scan statistics (valid also when the scan stops early)
+ *
+ * @return
+ *   - ESP_OK when the whole range was probed.
+ *   - ESP_ERR_TIMEOUT if the deadline expired; result holds the addresses probed so far.
+ *   - ESP_ERR_INVALID_STATE if the bus stayed faulty after a bus reset.
+ *   - ESP_ERR_INVALID_ARG for a bad range or missing arguments.
+ */
+esp_err_t i2c_scan(i2c_master_bus_handle_t bus, const i2c_scan_config_t *config, i2c_scan_result_t *result);
+
+/**
+ * @brief Scans several buses at the same time, one task per bus
+ *
+ * Each I2C controller runs its own transfers, so the buses are probed concurrently and the
+ * scan takes as long as the slowest bus. The same limits apply to every bus. A bus whose task
+ * cannot be created is scanned by the calling task once the others are running.
+ *
+ * @param buses  Initialized buses on different I2C controllers
+ * @param count  Number of buses, at most I2C_SCAN_MAX_BUSES
+ * @param config Scan limits, NULL for I2C_SCAN_CONFIG_DEFAULT()
+ * @param result Per-bus results in the order of buses, and the merged statistics
+ *
+ * @return
+ *   - ESP_OK when every bus was fully probed.
+ *   - The first error of i2c_scan() among the buses otherwise; see each bus status.
+ *   - ESP_ERR_INVALID_ARG for missing arguments or too many buses.
+ */
+esp_err_t i2c_scan_parallel(const i2c_master_bus_handle_t *buses, size_t count, const i2c_scan_config_t *config,
+                            i2c_scan_multi_result_t *result);
+
+#endif /* I2C_SCANNER_H */
@@ -1,8 +1,9 @@
 /**
  * Archivo: main.c
  * Descripción: Ejemplo de escáner de direcciones I2C para ESP32.
- *              Escanea todas las direcciones I2C posibles (1-127) e informa
- *              qué direcciones tienen dispositivos conectados.
+ *              Escanea en paralelo las direcciones I2C válidas (0x08-0x77) de los
+ *              dos controladores con sondeos de tiempo acotado, informa qué direcciones tienen dispositivos conectados
+ *              e identifica cada dispositivo leyendo sus registros.
  * Autor: migbertweb
  * Fecha: 2023-11-16
  * Repositorio: https://github.com/migbertweb/ESP32_ESP-IDF_Examples
@@ -17,61 +18,113 @@
 
 #include <stdio.h>
 #include <string.h>
-#include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2c_master.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
+#include "nvs_flash.h"
+#include "i2c_scanner.h"
+#include "i2c_identify.h"
+#include "i2c_monitor.h"
 
-// Configuración de pines I2C
+// Configuración de pines I2C del bus principal
 #define I2C_MASTER_SCL_IO           22      // Pin GPIO para el reloj I2C (SCL)
 #define I2C_MASTER_SDA_IO           21      // Pin GPIO para los datos I2C (SDA)
 #define I2C_MASTER_NUM             I2C_NUM_0 // Puerto I2C a utilizar
-#define I2C_MASTER_FREQ_HZ         1000000  // Frecuencia del reloj I2C (1MHz)
-#define I2C_MASTER_TX_BUF_DISABLE  0        // Deshabilitar búfer de transmisión
-#define I2C_MASTER_RX_BUF_DISABLE  0        // Deshabilitar búfer de recepción
-#define I2C_MASTER_TIMEOUT_MS      1000     // Tiempo de espera en milisegundos
+
+// Segundo bus en el otro controlador I2C del ESP32 (se escanea en paralelo)
+#define USE_SECOND_BUS             1        // 1 = escanear también el segundo bus
+#define I2C_SECOND_SCL_IO          32       // Pin GPIO para SCL del segundo bus
+#define I2C_SECOND_SDA_IO          33       // Pin GPIO para SDA del segundo bus
+#define I2C_SECOND_NUM             I2C_NUM_1 // Puerto I2C del segundo bus
+
+// Límites del escaneo: un dispositivo responde en unos pocos bits, el tiempo de espera
+// solo acota cuánto puede bloquear un fallo del bus cada sondeo
+#define I2C_PROBE_TIMEOUT_MS       10       // Tiempo de espera por dirección
+#define I2C_SCAN_DEADLINE_MS       200      // Tiempo máximo del escaneo completo
+#define I2C_SCAN_MAX_BUS_FAULTS    3        // Fallos seguidos del bus que detienen el escaneo
+
+// Vigilancia del bus tras el escaneo: detecta módulos conectados o retirados en caliente
+#define USE_HOTPLUG_MONITOR        1        // 1 = mantener el bus y vigilarlo, 0 = liberar el bus
+#define HOTPLUG_ADDRESSES_PER_TICK 4        // Direcciones sondeadas en cada ciclo
+#define HOTPLUG_TICK_MS            100      // Periodo de cada ciclo (pasada completa en ~3 s)
 
 // Etiqueta para mensajes de log
 static const char *TAG = "I2C_SCANNER";
 
+// Buses a escanear; el primero es el que se identifica y se vigila
+static const i2c_master_bus_config_t bus_configs[] = {
+    {
+        .i2c_port = I2C_MASTER_NUM,                  // Puerto I2C
+        .sda_io_num = I2C_MASTER_SDA_IO,             // Pin SDA
+        .scl_io_num = I2C_MASTER_SCL_IO,             // Pin SCL
+        .clk_source = I2C_CLK_SRC_DEFAULT,           // Fuente de reloj por defecto
+        .glitch_ignore_cnt = 7,                      // Filtro de interferencias
+        .flags.enable_internal_pullup = true,        // Habilitar pull-up en SDA y SCL
+    },
+#if USE_SECOND_BUS
+    {
+        .i2c_port = I2C_SECOND_NUM,
+        .sda_io_num = I2C_SECOND_SDA_IO,
+        .scl_io_num = I2C_SECOND_SCL_IO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    },
+#endif
+};
+
+#define I2C_BUS_COUNT              (sizeof(bus_configs) / sizeof(bus_configs[0]))
+
+// Buses I2C maestros, en el orden de bus_configs
+static i2c_master_bus_handle_t bus_handles[I2C_BUS_COUNT];
+
+// Dispositivos identificados en el bus
+static i2c_topology_t topology;
+
+#if USE_HOTPLUG_MONITOR
+// Vigilancia del bus (debe existir mientras la tarea esté activa)
+static i2c_monitor_t hotplug_monitor;
+
 /**
- * @brief Inicializa el controlador I2C en modo maestro
+ * @brief Recibe los eventos de conexión y desconexión de dispositivos
+ * 
+ * Se ejecuta en la tarea de vigilancia: aquí un controlador puede conectarse al
+ * dispositivo nuevo o dejar de usar el que se ha retirado.
+ */
+static void hotplug_event(const i2c_monitor_event_t *event, void *arg)
+{
+    if (event->type == I2C_MONITOR_ATTACHED) {
+        printf("Dispositivo conectado: 0x%02X (%s)\n", event->device.address,
+               i2c_dev_type_name(event->device.type));
+    } else {
+        printf("Dispositivo retirado: 0x%02X (%s)\n", event->device.address,
+               i2c_dev_type_name(event->device.type));
+    }
+}
+#endif
+
+/**
+ * @brief Inicializa los controladores I2C en modo maestro
  * 
  * @return esp_err_t Código de error ESP_OK si es exitoso
  */
 static esp_err_t i2c_master_init(void)
 {
-    esp_err_t ret;
-    
-    // Configuración del controlador I2C
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,                     // Modo maestro
-        .sda_io_num = I2C_MASTER_SDA_IO,            // Pin SDA
-        .scl_io_num = I2C_MASTER_SCL_IO,            // Pin SCL
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,         // Habilitar pull-up en SDA
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,         // Habilitar pull-up en SCL
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,      // Frecuencia del reloj
-        .clk_flags = 0,                              // Sin banderas especiales de reloj
-    };
-    
-    // Aplicar configuración al controlador I2C
-    ret = i2c_param_config(I2C_MASTER_NUM, &conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error al configurar parámetros I2C: %s", esp_err_to_name(ret));
-        return ret;
-    }
-    
-    // Instalar el controlador I2C
-    ret = i2c_driver_install(
-        I2C_MASTER_NUM,              // Puerto I2C
-        I2C_MODE_MASTER,             // Modo maestro
-        I2C_MASTER_RX_BUF_DISABLE,   // Tamaño del búfer de recepción
-        I2C_MASTER_TX_BUF_DISABLE,   // Tamaño del búfer de transmisión
-        0                            // Flags (0 para ninguno)
-    );
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error al instalar el controlador I2C: %s", esp_err_to_name(ret));
-        return ret;
+    for (size_t i = 0; i < I2C_BUS_COUNT; i++) {
+        // Crear el bus (el sondeo no necesita añadir dispositivos)
+        esp_err_t ret = i2c_new_master_bus(&bus_configs[i], &bus_handles[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Error al crear el bus I2C %d: %s", bus_configs[i].i2c_port, esp_err_to_name(ret));
+            // Liberar los buses ya creados
+            while (i-- > 0) {
+                i2c_del_master_bus(bus_handles[i]);
+            }
+            return ret;
+        }
+        ESP_LOGI(TAG, "Bus I2C %d: SDA=GPIO%d, SCL=GPIO%d", bus_configs[i].i2c_port,
+                 bus_configs[i].sda_io_num, bus_configs[i].scl_io_num);
     }
     
     ESP_LOGI(TAG, "Controlador I2C inicializado correctamente");
@@ -79,16 +132,14 @@ static esp_err_t i2c_master_init(void)
 }
 
 /**
- * @brief Escanea el bus I2C en busca de dispositivos
+ * @brief Muestra el resultado del escaneo como tabla de direcciones
+ * 
+ * @param port Puerto I2C del bus escaneado
+ * @param result Resultado del escaneo
  */
-static void i2c_scan(void)
+static void print_scan(int port, const i2c_scan_result_t *result)
 {
-    uint8_t address;
-    esp_err_t ret;
-    bool devices_found = false;
-    
-    ESP_LOGI(TAG, "Iniciando escaneo del bus I2C...");
-    printf("\nEscaneando bus I2C...\n");
+    printf("\nBus I2C %d:\n", port);
     printf("   ");
     
     // Encabezado de la tabla de direcciones
@@ -97,61 +148,75 @@ static void i2c_scan(void)
     }
     printf("\n   -------------------------------------------------\n");
     
-    // Escanear todas las direcciones I2C posibles (1-127)
     for (int i = 0; i < 128; i += 16) {
         printf("%02X:", i);
         for (int j = 0; j < 16; j++) {
-            address = i + j;
+            uint8_t address = i + j;
             
-            // Saltar direcciones reservadas (0x00-0x07, 0x78-0x7F)
-            if (address < 8 || address > 0x77) {
-                printf("   ");
+            // Direcciones reservadas (0x00-0x07, 0x78-0x7F) o no sondeadas
+            if (address < I2C_SCAN_FIRST_ADDRESS || address > I2C_SCAN_LAST_ADDRESS) {
+                printf("    ");
+                continue;
+            }
+            if (address >= result->next_address) {
+                printf("  ??");
                 continue;
             }
             
-            // Crear comando I2C
-            i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-            i2c_master_start(cmd);
-            // Enviar dirección con bit de escritura
-            i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
-            i2c_master_stop(cmd);
-            
-            // Ejecutar comando y verificar respuesta
-            ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
-            i2c_cmd_link_delete(cmd);
-            
-            // Si el dispositivo responde, mostrarlo
-            if (ret == ESP_OK) {
-                printf(" %02X", address);
-                devices_found = true;
-                
-                // Mostrar información adicional sobre dispositivos conocidos
-                if (address == 0x3C || address == 0x3D) {
-                    printf("(OLED)");
-                } else if (address == 0x68 || address == 0x69) {
-                    printf("(RTC/MPU)");
-                } else if (address >= 0x50 && address <= 0x57) {
-                    printf("(EEPROM)");
-                } else {
-                    printf("    ");
-                }
-            } else if (ret == ESP_ERR_TIMEOUT) {
-                printf(" --"); // Timeout
+            if (i2c_scan_bitmap_test(&result->found, address)) {
+                printf("  %02X", address);
             } else {
-                printf(" .."); // Error
+                printf("  --");
             }
         }
         printf("\n");
     }
     
-    if (!devices_found) {
+    if (result->count == 0) {
         printf("\n¡No se encontraron dispositivos I2C!\n");
         printf("Verifica las conexiones y asegúrate de que los dispositivos estén alimentados.\n");
     } else {
-        printf("\nEscaneo I2C completado.\n");
+        printf("\nEscaneo I2C completado: %d dispositivos en %lld us.\n", result->count, (long long)result->elapsed_us);
     }
 }
 
+/**
+ * @brief Muestra los dispositivos identificados en el bus
+ * 
+ * @param topology Dispositivos identificados
+ * @param from_cache true si la topología viene de la caché en NVS
+ */
+static void print_topology(const i2c_topology_t *topology, bool from_cache)
+{
+    printf("\nDispositivos identificados%s:\n", from_cache ? " (caché NVS, bus sin cambios)" : "");
+    for (int i = 0; i < topology->count; i++) {
+        const i2c_topology_entry_t *dev = &topology->devices[i];
+        const char *match = "";
+        if (dev->match == I2C_MATCH_FINGERPRINT) {
+            match = " (registros)";
+        } else if (dev->match == I2C_MATCH_ADDRESS) {
+            match = " (solo por dirección)";
+        }
+        printf("0x%02X: %s%s\n", dev->address, i2c_dev_type_name(dev->type), match);
+    }
+}
+
+/**
+ * @brief Inicializa la partición NVS donde se guarda la topología del bus
+ * 
+ * @return esp_err_t Código de error ESP_OK si es exitoso
+ */
+static esp_err_t nvs_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // La partición está llena o tiene otro formato: borrarla y volver a empezar
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    return ret;
+}
+
 /**
  * @brief Función principal de la aplicación
  */
@@ -165,14 +230,100 @@ void app_main(void)
     }
     
     ESP_LOGI(TAG, "Ejemplo de escáner I2C iniciado");
-    ESP_LOGI(TAG, "Pines: SDA=GPIO%d, SCL=GPIO%d", I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
     
-    // Realizar el escaneo I2C
-    i2c_scan();
+    // Realizar el escaneo I2C con tiempo acotado, así puede hacerse al arrancar
+    i2c_scan_config_t scan_config = I2C_SCAN_CONFIG_DEFAULT();
+    scan_config.probe_timeout_ms = I2C_PROBE_TIMEOUT_MS;
+    scan_config.deadline_ms = I2C_SCAN_DEADLINE_MS;
+    scan_config.max_bus_faults = I2C_SCAN_MAX_BUS_FAULTS;
+    
+    // Cada controlador escanea su bus desde una tarea propia: el tiempo total es el del bus más lento
+    printf("\nEscaneando %d buses I2C...\n", (int)I2C_BUS_COUNT);
+    static i2c_scan_multi_result_t scan;
+    i2c_scan_parallel(bus_handles, I2C_BUS_COUNT, &scan_config, &scan);
+    
+    for (size_t i = 0; i < scan.count; i++) {
+        const i2c_scan_bus_result_t *bus = &scan.buses[i];
+        int port = bus_configs[i].i2c_port;
+        
+        if (bus->status == ESP_ERR_TIMEOUT) {
+            ESP_LOGW(TAG, "Bus %d: escaneo interrumpido por tiempo en la dirección 0x%02X", port, bus->result.next_address);
+        } else if (bus->status != ESP_OK) {
+            ESP_LOGE(TAG, "Bus %d: escaneo interrumpido en la dirección 0x%02X: %s (%d fallos del bus)",
+                    port, bus->result.next_address, esp_err_to_name(bus->status), bus->result.bus_faults);
+        }
+        print_scan(port, &bus->result);
+    }
+    printf("\nTotal: %d dispositivos en %lld us (uno tras otro: %lld us)\n", scan.devices,
+           (long long)scan.elapsed_us, (long long)scan.sum_us);
+    
+    // Los buses secundarios solo se escanean
+    for (size_t i = 1; i < I2C_BUS_COUNT; i++) {
+        i2c_del_master_bus(bus_handles[i]);
+    }
+    
+    i2c_master_bus_handle_t bus_handle = bus_handles[0];
+    const i2c_scan_result_t *result = &scan.buses[0].result;
+    ret = scan.buses[0].status;
+    
+    // Identificar los dispositivos del bus principal; solo un escaneo completo describe el bus entero
+    bool identified = false;
+    bool nvs_ok = false;
+    if (ret == ESP_OK) {
+        bool from_cache = false;
+        
+        nvs_ok = nvs_init() == ESP_OK;
+        if (nvs_ok) {
+            ret = i2c_identify_cached(bus_handle, result, &topology, &from_cache);
+        } else {
+            ESP_LOGW(TAG, "NVS no disponible, identificación sin caché");
+            ret = i2c_identify(bus_handle, result, &topology);
+        }
+        
+        if (ret == ESP_OK) {
+            identified = true;
+            print_topology(&topology, from_cache);
+            
+            // Así un controlador encuentra su dispositivo sin conocer la dirección
+            uint8_t rtc_address;
+            if (i2c_topology_find(&topology, I2C_DEV_DS3231, 0, &rtc_address) == ESP_OK) {
+                ESP_LOGI(TAG, "RTC DS3231 disponible en 0x%02X", rtc_address);
+            }
+        } else {
+            ESP_LOGE(TAG, "Error al identificar dispositivos: %s", esp_err_to_name(ret));
+        }
+    }
+    
+#if USE_HOTPLUG_MONITOR
+    // Vigilar el bus con una tarea de baja prioridad que sondea unas pocas direcciones por ciclo
+    if (identified) {
+        i2c_monitor_config_t monitor_config = I2C_MONITOR_CONFIG_DEFAULT();
+        monitor_config.addresses_per_tick = HOTPLUG_ADDRESSES_PER_TICK;
+        monitor_config.tick_ms = HOTPLUG_TICK_MS;
+        monitor_config.probe_timeout_ms = I2C_PROBE_TIMEOUT_MS;
+        monitor_config.persist = nvs_ok;    // Mantener la caché al día para el próximo arranque
+        
+        ret = i2c_monitor_start(&hotplug_monitor, bus_handle, &topology, &monitor_config, hotplug_event, NULL);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "Vigilando el bus: conecta o retira módulos sin reiniciar");
+        } else {
+            ESP_LOGE(TAG, "Error al iniciar la vigilancia del bus: %s", esp_err_to_name(ret));
+            identified = false;
+        }
+    }
+    
+    if (!identified) {
+        i2c_del_master_bus(bus_handle);
+        ESP_LOGI(TAG, "Controlador I2C liberado");
+    }
+#else
+    (void)identified;
+    (void)nvs_ok;
     
     // No es necesario mantener el controlador I2C activo
-    i2c_driver_delete(I2C_MASTER_NUM);
+    i2c_del_master_bus(bus_handle);
     ESP_LOGI(TAG, "Controlador I2C liberado");
+#endif
     
     // El programa termina aquí, pero el bucle principal debe seguir ejecutándose
     while (1) {
@@ -36,12 +36,19 @@
 #define I2C_SLAVE_ADDR             0x0C    // Dirección del dispositivo esclavo
 #define I2C_DATA_LEN               14      // Longitud de los datos a leer
 
+// Enlace de comandos estático: START, dirección, lectura (datos + último byte con NACK) y STOP
+#define I2C_READ_LINK_OPS          3        // Operaciones de datos entre START y STOP
+
 // Búfer para almacenar los datos recibidos
 static uint8_t i2c_rx_buffer[I2C_DATA_LEN + 1] = {0}; // +1 para el carácter nulo
 
 // Etiqueta para mensajes de log
 static const char *TAG = "I2C_MASTER";
 
+// Memoria del enlace de comandos del esclavo: i2c_cmd_link_create_static() construye el enlace
+// en este búfer, así las lecturas periódicas no usan el heap. Cada tarea que lea del bus necesita el suyo.
+static uint8_t slave_link_buf[I2C_LINK_RECOMMENDED_SIZE(I2C_READ_LINK_OPS)];
+
 /**
  * @brief Inicializa el controlador I2C en modo maestro
  * 
@@ -101,11 +108,11 @@ static esp_err_t i2c_master_read_slave(uint8_t *data, size_t size)
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Crear un enlace de comandos I2C
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    // Crear el enlace de comandos I2C sobre el búfer preasignado del esclavo
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(slave_link_buf, sizeof(slave_link_buf));
     if (cmd == NULL) {
-        ESP_LOGE(TAG, "Error al crear el enlace de comandos I2C");
-        return ESP_ERR_NO_MEM;
+        ESP_LOGE(TAG, "Búfer del enlace de comandos I2C demasiado pequeño");
+        return ESP_ERR_INVALID_SIZE;
     }
     
     // Configurar la secuencia de comandos I2C
@@ -123,8 +130,8 @@ static esp_err_t i2c_master_read_slave(uint8_t *data, size_t size)
         pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS)
     );
     
-    // Liberar los recursos del enlace de comandos
-    i2c_cmd_link_delete(cmd);
+    // Liberar el enlace (el búfer se reutiliza en la siguiente lectura)
+    i2c_cmd_link_delete_static(cmd);
     
     if (ret != ESP_OK) {
         ESP_LOGD(TAG, "Error en la comunicación I2C: %s", esp_err_to_name(ret));
@@ -0,0 +1,226 @@
+/**
+ * Archivo: ds3231_host_main.c
+ * Descripción: Ejecuta el controlador DS3231 y la capa i2c_dev en Linux contra modelos de
+ *              dispositivos I2C. En el bus hay un DS3231 emulado (0x68) y una pantalla de solo
+ *              escritura (0x3C). Se comprueba la hora, la temperatura, la copia de registros
+ *              (sin escrituras repetidas), las alarmas, la respuesta a fallos inyectados (NACK,
+ *              tiempo agotado, latencia), la recuperación de un bus bloqueado y se mide el rendimiento del bus a 100 y 400 kHz.
+ *
+ * Uso: ./ds3231_host
+ *      Devuelve 1 si alguna comprobación falla.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ds3231.h"
+#include "i2c.h"
+#include "i2c_host.h"
+#include "i2c_models.h"
+#include "ds3231_model.h"
+#include "esp_timer.h"
+
+#define DISPLAY_ADDRESS 0x3C
+
+// Lecturas de los registros de hora por medida de rendimiento
+#define BENCH_TRANSACTIONS 1000
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { printf("FALLO %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+    } while (0)
+
+static ds3231_model_t rtc_model;
+static i2c_sink_t display_model;
+
+static void check_time(i2c_dev_t *dev)
+{
+    struct tm start = { .tm_year = 124, .tm_mon = 1, .tm_mday = 28, .tm_hour = 23, .tm_min = 59, .tm_sec = 58 };
+    struct tm now;
+
+    CHECK(ds3231_set_time(dev, &start) == ESP_OK, "ds3231_set_time");
+    ds3231_model_tick(&rtc_model, 3); // cruza el 29 de febrero de 2024 (año bisiesto)
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "ds3231_get_time");
+    CHECK(now.tm_mon == 1 && now.tm_mday == 29 && now.tm_hour == 0 && now.tm_min == 0 && now.tm_sec == 1,
+          "hora leída %02d-%02d %02d:%02d:%02d", now.tm_mon + 1, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec);
+
+    float temp = 0;
+    ds3231_snapshot_t snap;
+    CHECK(ds3231_read_snapshot(dev, &snap) == ESP_OK, "ds3231_read_snapshot");
+    ds3231_snapshot_get_temp_float(&snap, &temp);
+    CHECK(temp == 24.75f, "temperatura %.2f", temp);
+}
+
+static void check_shadow(i2c_dev_t *dev)
+{
+    ds3231_shadow_t shadow;
+
+    CHECK(ds3231_shadow_load(dev, &shadow) == ESP_OK, "ds3231_shadow_load");
+
+    // Escribir el valor que ya tiene el registro no genera tráfico
+    uint32_t writes = rtc_model.regfile.register_writes;
+    CHECK(ds3231_shadow_update_bits(dev, &shadow, DS3231_ADDR_CONTROL, DS3231_CTRL_ALARM_INTS, DS3231_CTRL_ALARM_INTS) == ESP_OK,
+          "update_bits sin cambios");
+    CHECK(rtc_model.regfile.register_writes == writes, "escritura innecesaria del registro de control");
+
+    // Alarma 1 a las 00:00:05 del día 29: salta tras 4 segundos y se borra con un 0
+    const uint8_t alarm1[4] = { dec2bcd(5), 0, 0, dec2bcd(29) };
+    CHECK(ds3231_shadow_write(dev, &shadow, DS3231_ADDR_ALARM1, alarm1, sizeof(alarm1)) == ESP_OK, "alarma 1");
+    ds3231_model_tick(&rtc_model, 4);
+    CHECK(rtc_model.regs[DS3231_ADDR_STATUS] & DS3231_STAT_ALARM_1, "A1F no activado");
+    ds3231_shadow_invalidate_status(&shadow);
+
+    // Una escritura que abarca el registro de estado con las banderas a 0 no borra A1F
+    const uint8_t ctrl_status[2] = { rtc_model.regs[DS3231_ADDR_CONTROL], DS3231_STAT_32KHZ };
+    CHECK(ds3231_shadow_write(dev, &shadow, DS3231_ADDR_CONTROL, ctrl_status, sizeof(ctrl_status)) == ESP_OK,
+          "escritura de control y estado");
+    CHECK(rtc_model.regs[DS3231_ADDR_STATUS] & DS3231_STAT_ALARM_1, "A1F borrado por ds3231_shadow_write");
+
+    CHECK(ds3231_clear_status_flags(dev, &shadow, DS3231_STAT_ALARM_1) == ESP_OK, "borrar A1F");
+    CHECK(!(rtc_model.regs[DS3231_ADDR_STATUS] & DS3231_STAT_ALARM_1), "A1F sigue activado");
+    CHECK(rtc_model.regs[DS3231_ADDR_STATUS] & DS3231_STAT_32KHZ, "EN32kHz borrado por error");
+}
+
+static void check_faults(i2c_dev_t *dev, i2c_dev_t *display)
+{
+    struct tm now;
+    i2c_dev_stats_t before, after;
+
+    i2c_dev_get_stats(dev, &before);
+
+    // Fallos persistentes: se agotan los reintentos y se devuelve el error; un NACK se reintenta una sola vez
+    int64_t nack_start = esp_timer_get_time();
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_NACK, I2CDEV_NACK_RETRIES + 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_ERR_INVALID_STATE, "NACK no detectado");
+    CHECK(esp_timer_get_time() - nack_start < I2CDEV_BACKOFF_MS * 1000, "espera entre reintentos de un NACK");
+
+    // Versiones anteriores del controlador devuelven ESP_FAIL en un NACK: mismo trato, sin reset del bus
+    uint32_t resets_before, resets, creations;
+    i2c_host_get_bus_counters(I2C_NUM_0, &resets_before, &creations);
+    nack_start = esp_timer_get_time();
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_NACK_FAIL, I2CDEV_NACK_RETRIES + 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_FAIL, "NACK como ESP_FAIL no detectado");
+    CHECK(esp_timer_get_time() - nack_start < I2CDEV_BACKOFF_MS * 1000, "espera entre reintentos de un NACK como ESP_FAIL");
+    i2c_host_get_bus_counters(I2C_NUM_0, &resets, &creations);
+    CHECK(resets == resets_before, "reset del bus tras un NACK como ESP_FAIL");
+
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_TIMEOUT, I2CDEV_MAX_RETRIES + 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_ERR_TIMEOUT, "tiempo agotado no detectado");
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "el fallo inyectado no se agotó");
+
+    // 3 ms de clock stretching: la lectura cae en el cubo de 2-5 ms del histograma
+    i2c_host_set_latency(I2C_NUM_0, DS3231_ADDR, 3000);
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "lectura con latencia");
+    i2c_host_set_latency(I2C_NUM_0, DS3231_ADDR, 0);
+
+    i2c_dev_get_stats(dev, &after);
+    CHECK(after.nacks == before.nacks + 2 * (I2CDEV_NACK_RETRIES + 1), "NACK contados %lu", (unsigned long)(after.nacks - before.nacks));
+    CHECK(after.timeouts == before.timeouts + I2CDEV_MAX_RETRIES + 1, "tiempos agotados contados %lu", (unsigned long)(after.timeouts - before.timeouts));
+    CHECK(after.histogram[5] == before.histogram[5] + 1, "latencia fuera del cubo de 2-5 ms");
+
+    // La pantalla solo admite escrituras
+    const uint8_t frame[16] = { 0x40, 0xff, 0x81, 0x81, 0xff };
+    uint8_t byte;
+    CHECK(i2c_dev_write(display, NULL, 0, frame, sizeof(frame)) == ESP_OK, "escritura en la pantalla");
+    CHECK(display_model.bytes == sizeof(frame) && display_model.last[1] == 0xff, "datos de la pantalla");
+    CHECK(i2c_dev_read(display, NULL, 0, &byte, 1) == ESP_ERR_INVALID_STATE, "lectura de la pantalla aceptada");
+}
+
+static void check_recovery(i2c_dev_t *dev)
+{
+    struct tm now;
+    i2c_bus_recovery_stats_t before, after;
+    i2c_dev_stats_t stats_before, stats_after;
+    uint32_t resets, creations, resets_before, creations_before;
+
+    i2c_bus_get_recovery_stats(I2C_NUM_0, &before);
+    i2c_dev_get_stats(dev, &stats_before);
+    i2c_host_get_bus_counters(I2C_NUM_0, &resets_before, &creations_before);
+
+    // Una interferencia deja SDA a nivel bajo: el reset del bus lo libera y el reintento funciona
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_STUCK, 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "lectura tras bus bloqueado");
+
+    // Si el reset del bus falla se reinicia el controlador y se vuelve a añadir el dispositivo
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_STUCK, 1);
+    i2c_host_fail_bus_reset(I2C_NUM_0, 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "lectura tras reiniciar el controlador");
+
+    // Un NACK puntual solo se reintenta
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_NACK, 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "lectura tras un NACK");
+
+    // Si además falla la creación del bus, el siguiente intento vuelve a crearlo en lugar de quedar sin bus
+    i2c_host_inject_fault(I2C_NUM_0, DS3231_ADDR, I2C_HOST_FAULT_STUCK, 1);
+    i2c_host_fail_bus_reset(I2C_NUM_0, 1);
+    i2c_host_fail_bus_create(I2C_NUM_0, 1);
+    CHECK(ds3231_get_time(dev, &now) == ESP_OK, "lectura tras fallar la creación del bus");
+
+    i2c_bus_get_recovery_stats(I2C_NUM_0, &after);
+    i2c_host_get_bus_counters(I2C_NUM_0, &resets, &creations);
+    CHECK(after.bus_resets - before.bus_resets == 3 && resets - resets_before == 3, "resets del bus %lu",
+          (unsigned long)(after.bus_resets - before.bus_resets));
+    CHECK(after.reinits - before.reinits == 3 && creations - creations_before == 2, "reinicios del controlador %lu",
+          (unsigned long)(after.reinits - before.reinits));
+    CHECK(after.retries - before.retries == 4 && after.recovered - before.recovered == 4, "reintentos %lu, recuperadas %lu",
+          (unsigned long)(after.retries - before.retries), (unsigned long)(after.recovered - before.recovered));
+    CHECK(after.failures - before.failures == 1, "recuperaciones fallidas %lu", (unsigned long)(after.failures - before.failures));
+
+    // Las estadísticas del dispositivo clasifican igual: un tiempo agotado por cada reset del bus
+    i2c_dev_get_stats(dev, &stats_after);
+    CHECK(stats_after.timeouts - stats_before.timeouts == after.bus_resets - before.bus_resets,
+          "tiempos agotados contados %lu", (unsigned long)(stats_after.timeouts - stats_before.timeouts));
+    CHECK(stats_after.nacks - stats_before.nacks == 1 && stats_after.errors == stats_before.errors,
+          "NACK contados %lu, errores %lu", (unsigned long)(stats_after.nacks - stats_before.nacks),
+          (unsigned long)(stats_after.errors - stats_before.errors));
+}
+
+static void bench(i2c_dev_t *dev, uint32_t speed)
+{
+    struct tm now;
+
+    CHECK(i2c_dev_set_speed(dev, speed) == ESP_OK, "i2c_dev_set_speed");
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_TRANSACTIONS; i++) ds3231_get_time(dev, &now);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    printf("%6lu Hz: %d lecturas de hora en %lld us de bus, %.0f transacciones/s\n", (unsigned long)speed,
+           BENCH_TRANSACTIONS, (long long)elapsed, BENCH_TRANSACTIONS * 1e6 / elapsed);
+}
+
+int main(void)
+{
+    struct tm power_on = { .tm_year = 124, .tm_mon = 0, .tm_mday = 1 };
+    i2c_dev_t dev = { 0 };
+    i2c_dev_t display = { .port = I2C_NUM_0, .addr = DISPLAY_ADDRESS, .sda_io_num = 21, .scl_io_num = 22, .clk_speed = I2C_FREQ_HZ };
+
+    ds3231_model_init(&rtc_model, &power_on, 24.75f);
+    i2c_host_attach(I2C_NUM_0, DS3231_ADDR, &i2c_regfile_model, &rtc_model.regfile);
+    i2c_host_attach(I2C_NUM_0, DISPLAY_ADDRESS, &i2c_sink_model, &display_model);
+
+    CHECK(ds3231_init_desc(&dev, I2C_NUM_0, 21, 22) == ESP_OK, "ds3231_init_desc");
+    CHECK(i2c_dev_create(&display) == ESP_OK, "i2c_dev_create (pantalla)");
+    // Crear un dispositivo ya creado no toma otra referencia del bus
+    CHECK(i2c_dev_create(&display) == ESP_OK, "i2c_dev_create repetido");
+
+    check_time(&dev);
+    check_shadow(&dev);
+    check_faults(&dev, &display);
+    check_recovery(&dev);
+
+    i2c_stats_dump();
+    i2c_trace_dump();
+
+    bench(&dev, 100000);
+    bench(&dev, 400000);
+
+    /* each device holds one reference on the port: deleting both frees the bus */
+    i2c_master_bus_handle_t bus;
+    CHECK(i2c_dev_delete(&display) == ESP_OK && i2c_dev_delete(&dev) == ESP_OK, "i2c_dev_delete");
+    CHECK(i2c_bus_get_handle(I2C_NUM_0, &bus) == ESP_ERR_INVALID_STATE, "el bus sigue creado tras borrar los dispositivos");
+    CHECK(i2c_dev_delete(&dev) == ESP_OK, "i2c_dev_delete repetido");
+
+    printf("%s\n", failures ? "Comprobaciones con fallos" : "Todas las comprobaciones correctas");
+    return failures ? 1 : 0;
+}
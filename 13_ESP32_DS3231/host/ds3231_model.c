@@ -0,0 +1,103 @@
+#include <string.h>
+#include "ds3231_model.h"
+
+static uint8_t write_hook(void *owner, uint8_t reg, uint8_t old_value, uint8_t value)
+{
+    (void)owner;
+
+    if (reg == DS3231_ADDR_STATUS)
+    {
+        // Flags are cleared by writing 0 and kept by writing 1; BSY is read-only
+        uint8_t flags = old_value & value & DS3231_STAT_FLAGS;
+        return flags | (value & DS3231_STAT_32KHZ) | (old_value & DS3231_STAT_BUSY);
+    }
+    if (reg >= DS3231_ADDR_TEMP) return old_value;
+
+    return value;
+}
+
+static void write_time(ds3231_model_t *model, const struct tm *time)
+{
+    model->regs[0] = dec2bcd(time->tm_sec);
+    model->regs[1] = dec2bcd(time->tm_min);
+    model->regs[2] = dec2bcd(time->tm_hour);
+    model->regs[3] = dec2bcd(time->tm_wday + 1);
+    model->regs[4] = dec2bcd(time->tm_mday);
+    model->regs[5] = dec2bcd(time->tm_mon + 1);
+    model->regs[6] = dec2bcd(time->tm_year - 100);
+}
+
+static void read_time(const ds3231_model_t *model, struct tm *time)
+{
+    memset(time, 0, sizeof(*time));
+    time->tm_sec = bcd2dec(model->regs[0]);
+    time->tm_min = bcd2dec(model->regs[1]);
+    time->tm_hour = bcd2dec(model->regs[2] & 0x3f);
+    time->tm_mday = bcd2dec(model->regs[4]);
+    time->tm_mon = bcd2dec(model->regs[5] & DS3231_MONTH_MASK) - 1;
+    time->tm_year = bcd2dec(model->regs[6]) + 100;
+}
+
+// An alarm register matches when its mask bit (bit 7) is set or its value equals the time
+static bool field_matches(uint8_t alarm, int value)
+{
+    return (alarm & DS3231_ALARM_NOTSET) || bcd2dec(alarm & 0x7f) == value;
+}
+
+static bool day_matches(uint8_t alarm, const struct tm *time)
+{
+    if (alarm & DS3231_ALARM_NOTSET) return true;
+    if (alarm & DS3231_ALARM_WDAY) return bcd2dec(alarm & 0x0f) == time->tm_wday + 1;
+    return bcd2dec(alarm & 0x3f) == time->tm_mday;
+}
+
+static void check_alarms(ds3231_model_t *model, const struct tm *time)
+{
+    const uint8_t *a1 = &model->regs[DS3231_ADDR_ALARM1];
+    const uint8_t *a2 = &model->regs[DS3231_ADDR_ALARM2];
+
+    if (field_matches(a1[0], time->tm_sec) && field_matches(a1[1], time->tm_min) &&
+        field_matches(a1[2], time->tm_hour) && day_matches(a1[3], time))
+        model->regs[DS3231_ADDR_STATUS] |= DS3231_STAT_ALARM_1;
+
+    if (time->tm_sec == 0 && field_matches(a2[0], time->tm_min) &&
+        field_matches(a2[1], time->tm_hour) && day_matches(a2[2], time))
+        model->regs[DS3231_ADDR_STATUS] |= DS3231_STAT_ALARM_2;
+}
+
+void ds3231_model_init(ds3231_model_t *model, const struct tm *time, float temperature)
+{
+    memset(model, 0, sizeof(*model));
+
+    struct tm t = *time;
+    time_t epoch = ds3231_tm_to_epoch(&t);
+    gmtime_r(&epoch, &t);
+    write_time(model, &t);
+
+    // State of a chip that kept running on the battery: INTCN and EN32kHz set, no flags
+    model->regs[DS3231_ADDR_CONTROL] = DS3231_CTRL_ALARM_INTS | DS3231_SQW_8192HZ;
+    model->regs[DS3231_ADDR_STATUS] = DS3231_STAT_32KHZ;
+
+    int16_t quarters = (int16_t)(temperature * 4);
+    model->regs[DS3231_ADDR_TEMP] = (uint8_t)(quarters >> 2);
+    model->regs[DS3231_ADDR_TEMP + 1] = (uint8_t)((quarters & 3) << 6);
+
+    model->regfile.regs = model->regs;
+    model->regfile.size = DS3231_REG_COUNT;
+    model->regfile.write_hook = write_hook;
+    model->regfile.owner = model;
+}
+
+void ds3231_model_tick(ds3231_model_t *model, uint32_t seconds)
+{
+    struct tm t;
+
+    for (uint32_t i = 0; i < seconds; i++)
+    {
+        read_time(model, &t);
+        time_t epoch = ds3231_tm_to_epoch(&t) + 1;
+        gmtime_r(&epoch, &t);
+        write_time(model, &t);
+        check_alarms(model, &t);
+    }
+}
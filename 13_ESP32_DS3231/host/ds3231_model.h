@@ -0,0 +1,29 @@
+#ifndef DS3231_MODEL_H
+#define DS3231_MODEL_H
+
+#include <time.h>
+#include "ds3231.h"
+#include "i2c_models.h"
+
+/**
+ * Emulated DS3231: a register file with the write rules of the real chip
+ * (status flags only clear on a 0, BSY and the temperature registers are read-only)
+ * and a clock that advances the time registers and raises the alarm flags.
+*/
+typedef struct
+{
+    uint8_t regs[DS3231_REG_COUNT];
+    i2c_regfile_t regfile;
+} ds3231_model_t;
+
+/**
+ * @brief Powers the model up with the given UTC time and temperature (in 0.25 °C steps)
+*/
+void ds3231_model_init(ds3231_model_t *model, const struct tm *time, float temperature);
+
+/**
+ * @brief Advances the time registers second by second, setting A1F/A2F on alarm matches
+*/
+void ds3231_model_tick(ds3231_model_t *model, uint32_t seconds);
+
+#endif /* DS3231_MODEL_H */
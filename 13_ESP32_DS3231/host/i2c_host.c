@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "i2c_host.h"
+
+typedef struct
+{
+    uint16_t address;
+    const i2c_host_model_t *model;
+    void *ctx;
+    i2c_host_fault_t fault;
+    uint32_t fault_count;
+    uint32_t stretch_us;
+    i2c_host_counters_t counters;
+} host_device_t;
+
+struct i2c_master_bus_t
+{
+    i2c_port_num_t port;
+    host_device_t devices[I2C_HOST_MAX_DEVICES];
+    int num_devices;
+    bool stuck;               // SDA held low by a device
+    uint32_t reset_failures;  // Pending failures of i2c_master_bus_reset()
+    uint32_t create_failures; // Pending failures of i2c_new_master_bus()
+    uint32_t resets;
+    uint32_t creations;
+    int attached;             // Devices added with i2c_master_bus_add_device()
+};
+
+struct i2c_master_dev_t
+{
+    struct i2c_master_bus_t *bus;
+    uint16_t address;
+    uint32_t scl_speed_hz;
+};
+
+static struct i2c_master_bus_t buses[I2C_NUM_MAX];
+static bool bus_created[I2C_NUM_MAX];
+static uint64_t host_now_ns; // Emulated time shared by every bus
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NOT_FINISHED: return "ESP_ERR_NOT_FINISHED";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return host_now_ns / 1000;
+}
+
+void i2c_host_advance(uint64_t us)
+{
+    host_now_ns += us * 1000ULL;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    i2c_host_advance(ticks * portTICK_PERIOD_MS * 1000ULL);
+}
+
+static host_device_t *find_device(struct i2c_master_bus_t *bus, uint16_t address)
+{
+    for (int i = 0; i < bus->num_devices; i++)
+        if (bus->devices[i].address == address) return &bus->devices[i];
+    return NULL;
+}
+
+static host_device_t *lookup(i2c_port_num_t port, uint16_t address)
+{
+    if (port < 0 || port >= I2C_NUM_MAX) return NULL;
+    return find_device(&buses[port], address);
+}
+
+// START, address byte and STOP, plus one byte and its ACK bit for every data byte
+static void advance_transfer(const struct i2c_master_dev_t *dev, size_t bytes)
+{
+    uint64_t byte_ns = 9ULL * 1000000000ULL / dev->scl_speed_hz;
+    host_now_ns += (bytes + 1) * byte_ns + 2 * byte_ns / 9;
+}
+
+esp_err_t i2c_host_attach(i2c_port_num_t port, uint16_t address, const i2c_host_model_t *model, void *ctx)
+{
+    if (port < 0 || port >= I2C_NUM_MAX || !model || !model->write) return ESP_ERR_INVALID_ARG;
+    if (find_device(&buses[port], address)) return ESP_ERR_INVALID_STATE;
+    if (buses[port].num_devices == I2C_HOST_MAX_DEVICES) return ESP_ERR_NO_MEM;
+
+    host_device_t *d = &buses[port].devices[buses[port].num_devices++];
+    memset(d, 0, sizeof(*d));
+    d->address = address;
+    d->model = model;
+    d->ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t i2c_host_inject_fault(i2c_port_num_t port, uint16_t address, i2c_host_fault_t fault, uint32_t count)
+{
+    host_device_t *d = lookup(port, address);
+    if (!d) return ESP_ERR_NOT_FOUND;
+
+    d->fault = fault;
+    d->fault_count = count;
+    return ESP_OK;
+}
+
+esp_err_t i2c_host_set_latency(i2c_port_num_t port, uint16_t address, uint32_t stretch_us)
+{
+    host_device_t *d = lookup(port, address);
+    if (!d) return ESP_ERR_NOT_FOUND;
+
+    d->stretch_us = stretch_us;
+    return ESP_OK;
+}
+
+esp_err_t i2c_host_fail_bus_reset(i2c_port_num_t port, uint32_t count)
+{
+    if (port < 0 || port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    buses[port].reset_failures = count;
+    return ESP_OK;
+}
+
+esp_err_t i2c_host_fail_bus_create(i2c_port_num_t port, uint32_t count)
+{
+    if (port < 0 || port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    buses[port].create_failures = count;
+    return ESP_OK;
+}
+
+void i2c_host_get_bus_counters(i2c_port_num_t port, uint32_t *resets, uint32_t *creations)
+{
+    *resets = buses[port].resets;
+    *creations = buses[port].creations;
+}
+
+esp_err_t i2c_host_get_counters(i2c_port_num_t port, uint16_t address, i2c_host_counters_t *counters)
+{
+    host_device_t *d = lookup(port, address);
+    if (!d || !counters) return d ? ESP_ERR_INVALID_ARG : ESP_ERR_NOT_FOUND;
+
+    *counters = d->counters;
+    return ESP_OK;
+}
+
+/*
+ * Common part of every transaction: address phase, injected faults and latency.
+ * Returns the device to talk to, or NULL with *res set when the transfer stops early.
+ */
+static host_device_t *begin(const struct i2c_master_dev_t *dev, int xfer_timeout_ms, esp_err_t *res)
+{
+    host_device_t *d = find_device(dev->bus, dev->address);
+
+    // SDA held low: the controller cannot even generate the START condition
+    if (dev->bus->stuck)
+    {
+        host_now_ns += xfer_timeout_ms * 1000000ULL;
+        if (d) d->counters.timeouts++;
+        *res = ESP_ERR_TIMEOUT;
+        return NULL;
+    }
+
+    // Nobody ACKs the address: the transfer stops after the first byte
+    if (!d)
+    {
+        advance_transfer(dev, 0);
+        *res = ESP_ERR_INVALID_STATE;
+        return NULL;
+    }
+
+    d->counters.transactions++;
+    if (d->fault_count)
+    {
+        d->fault_count--;
+        if (d->fault == I2C_HOST_FAULT_NACK || d->fault == I2C_HOST_FAULT_NACK_FAIL)
+        {
+            advance_transfer(dev, 0);
+            d->counters.nacks++;
+            *res = d->fault == I2C_HOST_FAULT_NACK ? ESP_ERR_INVALID_STATE : ESP_FAIL;
+            return NULL;
+        }
+        if (d->fault == I2C_HOST_FAULT_TIMEOUT || d->fault == I2C_HOST_FAULT_STUCK)
+        {
+            if (d->fault == I2C_HOST_FAULT_STUCK) dev->bus->stuck = true;
+            host_now_ns += xfer_timeout_ms * 1000000ULL;
+            d->counters.timeouts++;
+            *res = ESP_ERR_TIMEOUT;
+            return NULL;
+        }
+    }
+
+    host_now_ns += d->stretch_us * 1000ULL;
+    *res = ESP_OK;
+    return d;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    if (!bus_config || !ret_bus_handle || bus_config->i2c_port < 0 || bus_config->i2c_port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (bus_created[bus_config->i2c_port]) return ESP_ERR_INVALID_STATE;
+    if (buses[bus_config->i2c_port].create_failures)
+    {
+        buses[bus_config->i2c_port].create_failures--;
+        return ESP_FAIL;
+    }
+
+    // A new controller starts with a bus clear, which releases a stuck SDA
+    bus_created[bus_config->i2c_port] = true;
+    buses[bus_config->i2c_port].port = bus_config->i2c_port;
+    buses[bus_config->i2c_port].stuck = false;
+    buses[bus_config->i2c_port].creations++;
+    *ret_bus_handle = &buses[bus_config->i2c_port];
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle)
+{
+    if (!bus_handle) return ESP_ERR_INVALID_ARG;
+    if (bus_handle->attached) return ESP_ERR_INVALID_STATE;
+
+    bus_created[bus_handle->port] = false;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus_handle)
+{
+    if (!bus_handle) return ESP_ERR_INVALID_ARG;
+
+    bus_handle->resets++;
+    if (bus_handle->reset_failures)
+    {
+        bus_handle->reset_failures--;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Up to 9 SCL pulses and a STOP: about 10 bit times at 100 kHz
+    host_now_ns += 100000ULL;
+    bus_handle->stuck = false;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config, i2c_master_dev_handle_t *ret_handle)
+{
+    if (!bus_handle || !dev_config || !ret_handle || !dev_config->scl_speed_hz) return ESP_ERR_INVALID_ARG;
+
+    struct i2c_master_dev_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) return ESP_ERR_NO_MEM;
+
+    dev->bus = bus_handle;
+    dev->address = dev_config->device_address;
+    dev->scl_speed_hz = dev_config->scl_speed_hz;
+    bus_handle->attached++;
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    if (!handle) return ESP_ERR_INVALID_ARG;
+
+    handle->bus->attached--;
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size, int xfer_timeout_ms)
+{
+    if (!i2c_dev || !write_buffer) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res;
+    host_device_t *d = begin(i2c_dev, xfer_timeout_ms, &res);
+    if (!d) return res;
+
+    advance_transfer(i2c_dev, write_size);
+    if (!d->model->write(d->ctx, write_buffer, write_size))
+    {
+        d->counters.nacks++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    d->counters.bytes += write_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    if (!i2c_dev || !read_buffer || read_size == 0) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res;
+    host_device_t *d = begin(i2c_dev, xfer_timeout_ms, &res);
+    if (!d) return res;
+
+    // Write-only devices do not acknowledge their address in read mode
+    if (!d->model->read || !d->model->read(d->ctx, read_buffer, read_size))
+    {
+        advance_transfer(i2c_dev, 0);
+        d->counters.nacks++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    advance_transfer(i2c_dev, read_size);
+    d->counters.bytes += read_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                                      uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    if (!i2c_dev || !write_buffer || !read_buffer || read_size == 0) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res;
+    host_device_t *d = begin(i2c_dev, xfer_timeout_ms, &res);
+    if (!d) return res;
+
+    // Write phase, repeated START and read phase
+    advance_transfer(i2c_dev, write_size);
+    if (!d->model->write(d->ctx, write_buffer, write_size) || !d->model->read ||
+        !d->model->read(d->ctx, read_buffer, read_size))
+    {
+        d->counters.nacks++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    advance_transfer(i2c_dev, read_size);
+    d->counters.bytes += write_size + read_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!bus_handle) return ESP_ERR_INVALID_ARG;
+
+    return find_device(bus_handle, address) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,82 @@
+#ifndef I2C_HOST_H
+#define I2C_HOST_H
+
+#include <stdbool.h>
+#include "driver/i2c_master.h"
+
+// Maximum number of device models per bus
+#define I2C_HOST_MAX_DEVICES 8
+
+/**
+ * Behaviour of an emulated I2C device
+ * @var write handles one write transaction (bytes after the address byte); false NACKs it
+ * @var read fills one read transaction; false NACKs the address. NULL for write-only devices
+*/
+typedef struct
+{
+    bool (*write)(void *ctx, const uint8_t *data, size_t len);
+    bool (*read)(void *ctx, uint8_t *data, size_t len);
+} i2c_host_model_t;
+
+typedef enum
+{
+    I2C_HOST_FAULT_NONE,
+    I2C_HOST_FAULT_NACK,    // The address byte is not acknowledged
+    I2C_HOST_FAULT_NACK_FAIL, // Same, reported as ESP_FAIL like older driver releases do
+    I2C_HOST_FAULT_TIMEOUT, // SCL held low: the transfer waits the whole timeout
+    I2C_HOST_FAULT_STUCK,   // The device keeps SDA low: every transfer on the bus times out until a bus reset
+} i2c_host_fault_t;
+
+/**
+ * Traffic seen by one device model
+*/
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t nacks;
+    uint32_t timeouts;
+} i2c_host_counters_t;
+
+/**
+ * @brief Attaches a device model to a host I2C port
+ * @note  All devices share one emulated clock, advanced by the transfer time of each
+ *        transaction at the SCL speed of the device plus any injected latency.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the address is taken, ESP_ERR_NO_MEM if the port is full
+*/
+esp_err_t i2c_host_attach(i2c_port_num_t port, uint16_t address, const i2c_host_model_t *model, void *ctx);
+
+/**
+ * @brief Makes the next count transactions addressed to a device fail
+*/
+esp_err_t i2c_host_inject_fault(i2c_port_num_t port, uint16_t address, i2c_host_fault_t fault, uint32_t count);
+
+/**
+ * @brief Adds clock stretching to every transaction of a device
+*/
+esp_err_t i2c_host_set_latency(i2c_port_num_t port, uint16_t address, uint32_t stretch_us);
+
+/**
+ * @brief Makes the next count calls to i2c_master_bus_reset() on a port fail
+ * @note  A stuck bus is then only released when the bus is deleted and created again
+*/
+esp_err_t i2c_host_fail_bus_reset(i2c_port_num_t port, uint32_t count);
+
+/**
+ * @brief Makes the next count calls to i2c_new_master_bus() on a port fail
+*/
+esp_err_t i2c_host_fail_bus_create(i2c_port_num_t port, uint32_t count);
+
+/**
+ * @brief Number of bus resets and bus creations seen on a port
+*/
+void i2c_host_get_bus_counters(i2c_port_num_t port, uint32_t *resets, uint32_t *creations);
+
+esp_err_t i2c_host_get_counters(i2c_port_num_t port, uint16_t address, i2c_host_counters_t *counters);
+
+/**
+ * @brief Advances the emulated clock (time spent outside I2C transfers)
+*/
+void i2c_host_advance(uint64_t us);
+
+#endif /* I2C_HOST_H */
@@ -0,0 +1,53 @@
+#include <string.h>
+#include "i2c_models.h"
+
+static bool regfile_write(void *ctx, const uint8_t *data, size_t len)
+{
+    i2c_regfile_t *rf = ctx;
+
+    if (len == 0) return true;
+    rf->pointer = data[0] % rf->size;
+    for (size_t i = 1; i < len; i++)
+    {
+        uint8_t reg = rf->pointer;
+        uint8_t value = data[i];
+        if (rf->write_hook) value = rf->write_hook(rf->owner, reg, rf->regs[reg], value);
+        rf->regs[reg] = value;
+        rf->register_writes++;
+        rf->pointer = (rf->pointer + 1) % rf->size;
+    }
+    return true;
+}
+
+static bool regfile_read(void *ctx, uint8_t *data, size_t len)
+{
+    i2c_regfile_t *rf = ctx;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = rf->regs[rf->pointer];
+        rf->pointer = (rf->pointer + 1) % rf->size;
+    }
+    return true;
+}
+
+static bool sink_write(void *ctx, const uint8_t *data, size_t len)
+{
+    i2c_sink_t *sink = ctx;
+
+    sink->transactions++;
+    sink->bytes += len;
+    sink->last_len = len < I2C_SINK_KEEP ? len : I2C_SINK_KEEP;
+    memcpy(sink->last, data + len - sink->last_len, sink->last_len);
+    return true;
+}
+
+const i2c_host_model_t i2c_regfile_model = {
+    .write = regfile_write,
+    .read = regfile_read,
+};
+
+const i2c_host_model_t i2c_sink_model = {
+    .write = sink_write,
+    .read = NULL,
+};
@@ -0,0 +1,41 @@
+#ifndef I2C_MODELS_H
+#define I2C_MODELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "i2c_host.h"
+
+// Bytes of the last write kept by a sink
+#define I2C_SINK_KEEP 64
+
+/**
+ * Register-file device: the first byte of a write sets the register pointer, the rest are
+ * stored from there; reads return registers from the pointer. The pointer auto-increments
+ * and wraps at size, like the DS3231 and most sensors.
+ * @var write_hook optional: returns the value actually stored (read-only bits, write-to-clear flags)
+*/
+typedef struct
+{
+    uint8_t *regs;
+    size_t size;
+    uint8_t pointer;
+    uint8_t (*write_hook)(void *owner, uint8_t reg, uint8_t old_value, uint8_t value);
+    void *owner;
+    uint32_t register_writes; // Registers written (not counting the pointer byte)
+} i2c_regfile_t;
+
+/**
+ * Write-only sink, such as a display: counts the traffic and keeps the tail of the last write
+*/
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint8_t last[I2C_SINK_KEEP];
+    size_t last_len;
+} i2c_sink_t;
+
+extern const i2c_host_model_t i2c_regfile_model;
+extern const i2c_host_model_t i2c_sink_model;
+
+#endif /* I2C_MODELS_H */
@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Host build stand-in: returns the emulated time of the I2C buses, in microseconds
+int64_t esp_timer_get_time(void);
+
+#endif /* HOST_ESP_TIMER_H */
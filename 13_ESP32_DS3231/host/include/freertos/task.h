@@ -0,0 +1,9 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+// Host build stand-in: delays advance the emulated clock of the I2C buses
+void vTaskDelay(TickType_t ticks);
+
+#endif /* HOST_FREERTOS_TASK_H */
@@ -19,6 +19,49 @@ uint8_t dec2bcd(uint8_t val)
 	return ((val / 10) << 4) + (val % 10);
 }
 
+/* days since 1970-01-01 of a civil date, valid for any Gregorian year */
+static int64_t days_from_civil(int y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	int era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = (unsigned)(y - era * 400);
+	unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return (int64_t)era * 146097 + doe - 719468;
+}
+
+time_t ds3231_tm_to_epoch(const struct tm *time)
+{
+	/* the RTC keeps UTC, so this is timegm(): no time zone or DST applied */
+	int64_t days = days_from_civil(time->tm_year + 1900, time->tm_mon + 1, time->tm_mday);
+	return (time_t)(days * 86400 + time->tm_hour * 3600 + time->tm_min * 60 + time->tm_sec);
+}
+
+static int16_t decode_raw_temp(const uint8_t *data)
+{
+	return (int16_t)(int8_t)data[0] << 2 | data[1] >> 6;
+}
+
+static void decode_time(const uint8_t *data, struct tm *time)
+{
+	/* convert to unix time structure */
+	time->tm_sec = bcd2dec(data[0]);
+	time->tm_min = bcd2dec(data[1]);
+	if (data[2] & DS3231_12HOUR_FLAG)
+	{
+		/* 12H */
+		time->tm_hour = bcd2dec(data[2] & DS3231_12HOUR_MASK) - 1;
+		/* AM/PM? */
+		if (data[2] & DS3231_PM_FLAG) time->tm_hour += 12;
+	}
+	else time->tm_hour = bcd2dec(data[2]); /* 24H */
+	time->tm_wday = bcd2dec(data[3]) - 1;
+	time->tm_mday = bcd2dec(data[4]);
+	time->tm_mon  = bcd2dec(data[5] & DS3231_MONTH_MASK) - 1;
+	time->tm_year = bcd2dec(data[6]) + 100; /* years since 1900, the RTC counts from 2000 */
+	time->tm_isdst = 0;
+}
+
 esp_err_t ds3231_init_desc(i2c_dev_t *dev, i2c_port_t port, gpio_num_t sda_gpio, gpio_num_t scl_gpio)
 {
 	CHECK_ARG(dev);
@@ -27,7 +70,11 @@ esp_err_t ds3231_init_desc(i2c_dev_t *dev, i2c_port_t port, gpio_num_t sda_gpio,
 	dev->sda_io_num = sda_gpio;  
 	dev->scl_io_num = scl_gpio;
 	dev->clk_speed = I2C_FREQ_HZ;
-	return i2c_dev_init(port, sda_gpio, scl_gpio);
+	dev->handle = NULL;
+
+	/* the device handle is created once here and reused by every transaction;
+	 * it holds the only reference on the port, released by i2c_dev_delete() */
+	return i2c_dev_create(dev);
 }
 
 esp_err_t ds3231_set_time(i2c_dev_t *dev, struct tm *time)
@@ -45,7 +92,7 @@ esp_err_t ds3231_set_time(i2c_dev_t *dev, struct tm *time)
 	data[3] = dec2bcd(time->tm_wday + 1);
 	data[4] = dec2bcd(time->tm_mday);
 	data[5] = dec2bcd(time->tm_mon + 1);
-	data[6] = dec2bcd(time->tm_year - 2000);
+	data[6] = dec2bcd(time->tm_year - 100);
 
 	return i2c_dev_write_reg(dev, DS3231_ADDR_TIME, data, 7);
 }
@@ -59,7 +106,7 @@ esp_err_t ds3231_get_raw_temp(i2c_dev_t *dev, int16_t *temp)
 
 	esp_err_t res = i2c_dev_read_reg(dev, DS3231_ADDR_TEMP, data, sizeof(data));
 	if (res == ESP_OK)
-		*temp = (int16_t)(int8_t)data[0] << 2 | data[1] >> 6;
+		*temp = decode_raw_temp(data);
 
 	return res;
 }
@@ -101,21 +148,237 @@ esp_err_t ds3231_get_time(i2c_dev_t *dev, struct tm *time)
 	esp_err_t res = i2c_dev_read_reg(dev, DS3231_ADDR_TIME, data, 7);
 		if (res != ESP_OK) return res;
 
-	/* convert to unix time structure */
-	time->tm_sec = bcd2dec(data[0]);
-	time->tm_min = bcd2dec(data[1]);
-	if (data[2] & DS3231_12HOUR_FLAG)
+	decode_time(data, time);
+	return ESP_OK;
+}
+
+esp_err_t ds3231_get_aging_offset(i2c_dev_t *dev, int8_t *age)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(age);
+
+	uint8_t data;
+
+	esp_err_t res = i2c_dev_read_reg(dev, DS3231_ADDR_AGING, &data, 1);
+	if (res == ESP_OK)
+		*age = (int8_t)data;
+
+	return res;
+}
+
+esp_err_t ds3231_read_snapshot(i2c_dev_t *dev, ds3231_snapshot_t *snap)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(snap);
+
+	/* the register pointer auto-increments, so one read covers 0x00-0x12 */
+	return i2c_dev_read_reg(dev, DS3231_ADDR_TIME, snap->regs, DS3231_REG_COUNT);
+}
+
+esp_err_t ds3231_snapshot_get_time(const ds3231_snapshot_t *snap, struct tm *time)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(time);
+
+	decode_time(&snap->regs[DS3231_ADDR_TIME], time);
+	return ESP_OK;
+}
+
+esp_err_t ds3231_snapshot_get_raw_temp(const ds3231_snapshot_t *snap, int16_t *temp)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(temp);
+
+	*temp = decode_raw_temp(&snap->regs[DS3231_ADDR_TEMP]);
+	return ESP_OK;
+}
+
+esp_err_t ds3231_snapshot_get_temp_float(const ds3231_snapshot_t *snap, float *temp)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(temp);
+
+	*temp = decode_raw_temp(&snap->regs[DS3231_ADDR_TEMP]) * 0.25;
+	return ESP_OK;
+}
+
+esp_err_t ds3231_snapshot_get_status(const ds3231_snapshot_t *snap, uint8_t *status)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(status);
+
+	*status = snap->regs[DS3231_ADDR_STATUS];
+	return ESP_OK;
+}
+
+esp_err_t ds3231_snapshot_get_control(const ds3231_snapshot_t *snap, uint8_t *control)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(control);
+
+	*control = snap->regs[DS3231_ADDR_CONTROL];
+	return ESP_OK;
+}
+
+esp_err_t ds3231_snapshot_get_aging_offset(const ds3231_snapshot_t *snap, int8_t *age)
+{
+	CHECK_ARG(snap);
+	CHECK_ARG(age);
+
+	*age = (int8_t)snap->regs[DS3231_ADDR_AGING];
+	return ESP_OK;
+}
+
+esp_err_t ds3231_shadow_load(i2c_dev_t *dev, ds3231_shadow_t *shadow)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+
+	esp_err_t res = i2c_dev_read_reg(dev, DS3231_SHADOW_FIRST, shadow->regs, DS3231_SHADOW_COUNT);
+	shadow->valid = res == ESP_OK;
+	shadow->status_valid = res == ESP_OK;
+
+	return res;
+}
+
+esp_err_t ds3231_shadow_load_snapshot(ds3231_shadow_t *shadow, const ds3231_snapshot_t *snap)
+{
+	CHECK_ARG(shadow);
+	CHECK_ARG(snap);
+
+	memcpy(shadow->regs, &snap->regs[DS3231_SHADOW_FIRST], DS3231_SHADOW_COUNT);
+	shadow->valid = true;
+	shadow->status_valid = true;
+
+	return ESP_OK;
+}
+
+void ds3231_shadow_invalidate_status(ds3231_shadow_t *shadow)
+{
+	if (shadow) shadow->status_valid = false;
+}
+
+static bool shadow_contains(uint8_t reg, size_t len)
+{
+	return reg >= DS3231_SHADOW_FIRST && reg + len <= DS3231_SHADOW_FIRST + DS3231_SHADOW_COUNT;
+}
+
+esp_err_t ds3231_shadow_get(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, uint8_t *value)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+	CHECK_ARG(value);
+	if (!shadow_contains(reg, 1)) return ESP_ERR_INVALID_ARG;
+
+	esp_err_t res = ESP_OK;
+	if (!shadow->valid)
+		res = ds3231_shadow_load(dev, shadow);
+	else if (reg == DS3231_ADDR_STATUS && !shadow->status_valid)
 	{
-		/* 12H */
-		time->tm_hour = bcd2dec(data[2] & DS3231_12HOUR_MASK) - 1;
-		/* AM/PM? */
-		if (data[2] & DS3231_PM_FLAG) time->tm_hour += 12;
+		res = i2c_dev_read_reg(dev, DS3231_ADDR_STATUS, &shadow->regs[DS3231_ADDR_STATUS - DS3231_SHADOW_FIRST], 1);
+		shadow->status_valid = res == ESP_OK;
 	}
-	else time->tm_hour = bcd2dec(data[2]); /* 24H */
-	time->tm_wday = bcd2dec(data[3]) - 1;
-	time->tm_mday = bcd2dec(data[4]);
-	time->tm_mon  = bcd2dec(data[5] & DS3231_MONTH_MASK) - 1;
-	time->tm_year = bcd2dec(data[6]) + 2000;
-	time->tm_isdst = 0;
+	if (res != ESP_OK) return res;
+
+	*value = shadow->regs[reg - DS3231_SHADOW_FIRST];
 	return ESP_OK;
-}
\ No newline at end of file
+}
+
+/* true if writing data leaves the registers as cached; status flags written as 1 keep their value */
+static bool shadow_unchanged(const uint8_t *cached, const uint8_t *data, uint8_t reg, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+	{
+		uint8_t keep = reg + i == DS3231_ADDR_STATUS ? DS3231_STAT_FLAGS : 0;
+		if ((cached[i] | keep) != (data[i] | keep)) return false;
+	}
+	return true;
+}
+
+esp_err_t ds3231_shadow_write(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, const uint8_t *data, size_t len)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+	CHECK_ARG(data);
+	if (!len || !shadow_contains(reg, len)) return ESP_ERR_INVALID_ARG;
+
+	uint8_t *cached = &shadow->regs[reg - DS3231_SHADOW_FIRST];
+	bool has_status = reg <= DS3231_ADDR_STATUS && reg + len > DS3231_ADDR_STATUS;
+
+	/*
+	 * OSF, A1F and A2F are cleared by writing 0: write them as 1 so a range that covers the
+	 * status register never clears a flag the device raised; ds3231_clear_status_flags() clears them
+	 */
+	uint8_t out[DS3231_SHADOW_COUNT];
+	memcpy(out, data, len);
+	if (has_status) out[DS3231_ADDR_STATUS - reg] |= DS3231_STAT_FLAGS;
+
+	/* nothing to do if the registers already hold these values */
+	if (shadow->valid && (!has_status || shadow->status_valid) && shadow_unchanged(cached, out, reg, len))
+		return ESP_OK;
+
+	esp_err_t res = i2c_dev_write_reg(dev, reg, out, len);
+	if (res != ESP_OK)
+	{
+		/* the device may or may not have taken the write */
+		shadow->valid = false;
+		return res;
+	}
+
+	if (shadow->valid) memcpy(cached, out, len);
+	/* flags written as 1 keep whatever value the hardware has */
+	if (has_status) shadow->status_valid = false;
+
+	return ESP_OK;
+}
+
+static esp_err_t shadow_update_bits(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, uint8_t mask, uint8_t value)
+{
+	if (!shadow->valid)
+	{
+		esp_err_t res = ds3231_shadow_load(dev, shadow);
+		if (res != ESP_OK) return res;
+	}
+
+	uint8_t *cached = &shadow->regs[reg - DS3231_SHADOW_FIRST];
+	uint8_t data = (*cached & ~mask) | (value & mask);
+
+	if (reg != DS3231_ADDR_STATUS)
+		return ds3231_shadow_write(dev, shadow, reg, &data, 1);
+
+	if (shadow->status_valid && data == *cached) return ESP_OK;
+
+	/* never write a stale 0 to a flag: 1 leaves it unchanged, 0 only where a clear is requested */
+	uint8_t out = data | (DS3231_STAT_FLAGS & ~(mask & ~value));
+	esp_err_t res = i2c_dev_write_reg(dev, reg, &out, 1);
+	if (res == ESP_OK) *cached = data;
+	else shadow->valid = false;
+
+	return res;
+}
+
+esp_err_t ds3231_shadow_update_bits(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, uint8_t mask, uint8_t value)
+{
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+	if (!shadow_contains(reg, 1)) return ESP_ERR_INVALID_ARG;
+
+	/* the bus stays locked from the reload to the write, so no other task interleaves */
+	I2C_DEV_TAKE(dev);
+	esp_err_t res = shadow_update_bits(dev, shadow, reg, mask, value);
+	I2C_DEV_GIVE(dev);
+
+	return res;
+}
+
+esp_err_t ds3231_clear_status_flags(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t flags)
+{
+	return ds3231_shadow_update_bits(dev, shadow, DS3231_ADDR_STATUS, flags & DS3231_STAT_FLAGS, 0);
+}
+
+esp_err_t ds3231_enable_squarewave(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t freq)
+{
+	/* INTCN = 0 routes the square wave to the INT/SQW pin instead of the alarm interrupt */
+	return ds3231_shadow_update_bits(dev, shadow, DS3231_ADDR_CONTROL,
+			DS3231_CTRL_ALARM_INTS | DS3231_SQW_MASK, freq & DS3231_SQW_MASK);
+}
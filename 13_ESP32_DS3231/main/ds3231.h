@@ -3,7 +3,6 @@
 
 #include <time.h>
 #include <stdbool.h>
-#include "driver/i2c.h"
 
 #include "i2c.h"
 
@@ -18,10 +17,19 @@
 #define DS3231_CTRL_OSCILLATOR    0x80
 #define DS3231_CTRL_SQUAREWAVE_BB 0x40
 #define DS3231_CTRL_TEMPCONV      0x20
+#define DS3231_CTRL_RATE_SEL2     0x10
+#define DS3231_CTRL_RATE_SEL1     0x08
 #define DS3231_CTRL_ALARM_INTS    0x04
 #define DS3231_CTRL_ALARM2_INT    0x02
 #define DS3231_CTRL_ALARM1_INT    0x01
 
+/* square wave frequency, RS2:RS1 bits of the control register (INTCN must be 0) */
+#define DS3231_SQW_1HZ      0x00
+#define DS3231_SQW_1024HZ   DS3231_CTRL_RATE_SEL1
+#define DS3231_SQW_4096HZ   DS3231_CTRL_RATE_SEL2
+#define DS3231_SQW_8192HZ   (DS3231_CTRL_RATE_SEL2 | DS3231_CTRL_RATE_SEL1)
+#define DS3231_SQW_MASK     (DS3231_CTRL_RATE_SEL2 | DS3231_CTRL_RATE_SEL1)
+
 #define DS3231_ALARM_WDAY   0x40
 #define DS3231_ALARM_NOTSET 0x80
 
@@ -33,17 +41,66 @@
 #define DS3231_ADDR_AGING   0x10
 #define DS3231_ADDR_TEMP    0x11
 
+#define DS3231_REG_COUNT    0x13 //!< Registers 0x00-0x12: time, alarms, control, status, aging, temperature
+
+#define DS3231_SHADOW_FIRST DS3231_ADDR_ALARM1 //!< First register kept in the shadow cache
+#define DS3231_SHADOW_COUNT (DS3231_ADDR_AGING - DS3231_ADDR_ALARM1 + 1) //!< Alarms, control, status, aging
+
+/* Status flags the hardware sets and software can only clear (writing 1 leaves them unchanged) */
+#define DS3231_STAT_FLAGS (DS3231_STAT_OSCILLATOR | DS3231_STAT_ALARM_2 | DS3231_STAT_ALARM_1)
+
 #define DS3231_12HOUR_FLAG  0x40
 #define DS3231_12HOUR_MASK  0x1f
 #define DS3231_PM_FLAG      0x20
 #define DS3231_MONTH_MASK   0x1f
 
+/**
+ * Image of the whole DS3231 register file, read in a single I2C transaction.
+ * Index the registers with the DS3231_ADDR_* constants.
+ */
+typedef struct {
+	uint8_t regs[DS3231_REG_COUNT];
+} ds3231_snapshot_t;
+
+/**
+ * Write-through shadow of the configuration registers (alarms, control, status, aging).
+ * Bit updates are a single write from the cached value, and writes that would not change
+ * anything are skipped. The status flags are set by the hardware, so the status byte is
+ * only trusted until ds3231_shadow_invalidate_status() is called (e.g. on an INT edge).
+ */
+typedef struct {
+	uint8_t regs[DS3231_SHADOW_COUNT];
+	bool valid;          // configuration registers loaded
+	bool status_valid;   // status flags reflect the hardware
+} ds3231_shadow_t;
+
 uint8_t bcd2dec(uint8_t val);
 uint8_t dec2bcd(uint8_t val);
+time_t ds3231_tm_to_epoch(const struct tm *time);
 esp_err_t ds3231_init_desc(i2c_dev_t *dev, i2c_port_t port, gpio_num_t sda_gpio, gpio_num_t scl_gpio);
 esp_err_t ds3231_set_time(i2c_dev_t *dev, struct tm *time);
 esp_err_t ds3231_get_raw_temp(i2c_dev_t *dev, int16_t *temp);
 esp_err_t ds3231_get_temp_integer(i2c_dev_t *dev, int8_t *temp);
 esp_err_t ds3231_get_temp_float(i2c_dev_t *dev, float *temp);
 esp_err_t ds3231_get_time(i2c_dev_t *dev, struct tm *time);
+esp_err_t ds3231_get_aging_offset(i2c_dev_t *dev, int8_t *age);
+
+/* Snapshot API: one burst read, then decode from the cached image without bus traffic */
+esp_err_t ds3231_read_snapshot(i2c_dev_t *dev, ds3231_snapshot_t *snap);
+esp_err_t ds3231_snapshot_get_time(const ds3231_snapshot_t *snap, struct tm *time);
+esp_err_t ds3231_snapshot_get_raw_temp(const ds3231_snapshot_t *snap, int16_t *temp);
+esp_err_t ds3231_snapshot_get_temp_float(const ds3231_snapshot_t *snap, float *temp);
+esp_err_t ds3231_snapshot_get_status(const ds3231_snapshot_t *snap, uint8_t *status);
+esp_err_t ds3231_snapshot_get_control(const ds3231_snapshot_t *snap, uint8_t *control);
+esp_err_t ds3231_snapshot_get_aging_offset(const ds3231_snapshot_t *snap, int8_t *age);
+
+/* Shadow register cache for registers DS3231_ADDR_ALARM1 to DS3231_ADDR_AGING */
+esp_err_t ds3231_shadow_load(i2c_dev_t *dev, ds3231_shadow_t *shadow);
+esp_err_t ds3231_shadow_load_snapshot(ds3231_shadow_t *shadow, const ds3231_snapshot_t *snap);
+void ds3231_shadow_invalidate_status(ds3231_shadow_t *shadow);
+esp_err_t ds3231_shadow_get(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, uint8_t *value);
+esp_err_t ds3231_shadow_write(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, const uint8_t *data, size_t len);
+esp_err_t ds3231_shadow_update_bits(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t reg, uint8_t mask, uint8_t value);
+esp_err_t ds3231_clear_status_flags(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t flags);
+esp_err_t ds3231_enable_squarewave(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t freq);
 #endif /* MAIN_DS3231_H_ */
@@ -0,0 +1,305 @@
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "ds3231_alarm.h"
+
+#define TAG "DS3231_ALARM"
+
+#define CHECK_ARG(ARG) do { if (!ARG) return ESP_ERR_INVALID_ARG; } while (0)
+
+esp_err_t ds3231_set_alarm1(i2c_dev_t *dev, ds3231_shadow_t *shadow, const struct tm *time)
+{
+	CHECK_ARG(time);
+	uint8_t data[4];
+
+	/* A1M1-A1M4 = 0 and DY/DT = 0: match seconds, minutes, hours and day of month */
+	data[0] = dec2bcd(time->tm_sec);
+	data[1] = dec2bcd(time->tm_min);
+	data[2] = dec2bcd(time->tm_hour);
+	data[3] = dec2bcd(time->tm_mday);
+
+	return ds3231_shadow_write(dev, shadow, DS3231_ADDR_ALARM1, data, sizeof(data));
+}
+
+esp_err_t ds3231_set_alarm2(i2c_dev_t *dev, ds3231_shadow_t *shadow, const struct tm *time)
+{
+	CHECK_ARG(time);
+	uint8_t data[3];
+
+	/* A2M2-A2M4 = 0 and DY/DT = 0: match minutes, hours and day of month (at seconds 00) */
+	data[0] = dec2bcd(time->tm_min);
+	data[1] = dec2bcd(time->tm_hour);
+	data[2] = dec2bcd(time->tm_mday);
+
+	return ds3231_shadow_write(dev, shadow, DS3231_ADDR_ALARM2, data, sizeof(data));
+}
+
+esp_err_t ds3231_enable_alarm_ints(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t alarms)
+{
+	alarms &= DS3231_CTRL_ALARM1_INT | DS3231_CTRL_ALARM2_INT;
+
+	/* INTCN = 1 routes the alarms to the INT/SQW pin */
+	return ds3231_shadow_update_bits(dev, shadow, DS3231_ADDR_CONTROL,
+			DS3231_CTRL_ALARM_INTS | DS3231_CTRL_ALARM1_INT | DS3231_CTRL_ALARM2_INT,
+			DS3231_CTRL_ALARM_INTS | alarms);
+}
+
+static void IRAM_ATTR sched_isr(void *arg)
+{
+	ds3231_sched_t *sched = (ds3231_sched_t *)arg;
+	BaseType_t woken = pdFALSE;
+
+	/* INT stays low until the flags are cleared: mask the level interrupt until then */
+	gpio_intr_disable(sched->pin);
+	vTaskNotifyGiveFromISR(sched->task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+static esp_err_t sched_now(ds3231_sched_t *sched, time_t *now)
+{
+	struct tm time;
+
+	esp_err_t res = ds3231_get_time(sched->dev, &time);
+	if (res == ESP_OK) *now = ds3231_tm_to_epoch(&time);
+
+	return res;
+}
+
+/* programs the two earliest deadlines into the alarms; called with the lock held */
+static esp_err_t sched_program(ds3231_sched_t *sched, time_t now)
+{
+	time_t first = 0, second = 0;
+
+	for (int i = 0; i < DS3231_SCHED_MAX_TIMERS; i++)
+	{
+		if (!sched->timers[i].active) continue;
+		time_t d = sched->timers[i].deadline;
+		if (!first || d < first) { second = first; first = d; }
+		else if (d != first && (!second || d < second)) second = d;
+	}
+
+	/* beyond the day-of-month horizon: wake up halfway and reprogram */
+	if (first && first - now > DS3231_SCHED_HORIZON_S) { first = now + DS3231_SCHED_HORIZON_S; second = 0; }
+	if (second && second - now > DS3231_SCHED_HORIZON_S) second = 0;
+
+	time_t a1 = first, a2 = 0;
+	if (second && second % 60 == 0) a2 = second;
+	else if (first && first % 60 == 0 && second) { a2 = first; a1 = second; }
+
+	struct tm time;
+	esp_err_t res = ESP_OK;
+	uint8_t enabled = 0;
+
+	if (a1)
+	{
+		gmtime_r(&a1, &time);
+		res = ds3231_set_alarm1(sched->dev, sched->shadow, &time);
+		enabled |= DS3231_CTRL_ALARM1_INT;
+	}
+	if (res == ESP_OK && a2)
+	{
+		gmtime_r(&a2, &time);
+		res = ds3231_set_alarm2(sched->dev, sched->shadow, &time);
+		enabled |= DS3231_CTRL_ALARM2_INT;
+	}
+	if (res == ESP_OK) res = ds3231_enable_alarm_ints(sched->dev, sched->shadow, enabled);
+	if (res != ESP_OK) return res;
+
+	sched->armed[0] = a1;
+	sched->armed[1] = a2;
+
+	/*
+	 * a deadline that passed before or while the alarms were written would never match:
+	 * read the time again, now that the registers hold it, and handle it in the task
+	 */
+	if (first)
+	{
+		time_t after;
+		res = sched_now(sched, &after);
+		if (res != ESP_OK) return res;
+		if (first <= after) xTaskNotifyGive(sched->task);
+	}
+
+	return ESP_OK;
+}
+
+static void sched_task(void *arg)
+{
+	ds3231_sched_t *sched = (ds3231_sched_t *)arg;
+	ds3231_timer_t expired[DS3231_SCHED_MAX_TIMERS];
+	TickType_t wait = portMAX_DELAY;
+
+	while (1)
+	{
+		/* a timeout is a retry after a failure, not an interrupt */
+		if (ulTaskNotifyTake(pdTRUE, wait)) sched->interrupts++;
+
+		int count = 0;
+		time_t now;
+
+		xSemaphoreTake(sched->lock, portMAX_DELAY);
+		ds3231_shadow_invalidate_status(sched->shadow);
+		esp_err_t res = ds3231_clear_status_flags(sched->dev, sched->shadow, DS3231_STAT_ALARM_1 | DS3231_STAT_ALARM_2);
+		if (res == ESP_OK) res = sched_now(sched, &now);
+
+		if (res == ESP_OK)
+		{
+			for (int i = 0; i < DS3231_SCHED_MAX_TIMERS; i++)
+			{
+				ds3231_timer_t *t = &sched->timers[i];
+				if (!t->active || t->deadline > now) continue;
+
+				expired[count++] = *t;
+				if (t->period)
+				{
+					/* skip the periods missed while the alarm was late */
+					while (t->deadline <= now) t->deadline += t->period;
+				}
+				else t->active = false;
+			}
+			res = sched_program(sched, now);
+		}
+		xSemaphoreGive(sched->lock);
+
+		/*
+		 * with the flags possibly still set INT stays low, and the level interrupt would fire again
+		 * right away: keep it masked and try again after a delay
+		 */
+		if (res == ESP_OK)
+		{
+			gpio_intr_enable(sched->pin);
+			wait = portMAX_DELAY;
+		}
+		else
+		{
+			ESP_LOGE(TAG, "Alarm handling failed, retrying in %d ms: %s", DS3231_SCHED_RETRY_MS, esp_err_to_name(res));
+			wait = pdMS_TO_TICKS(DS3231_SCHED_RETRY_MS);
+		}
+
+		/* callbacks run without the lock so they can add or cancel timers */
+		for (int i = 0; i < count; i++)
+		{
+			expired[i].callback(expired[i].arg);
+			sched->dispatched++;
+		}
+	}
+}
+
+esp_err_t ds3231_sched_start(ds3231_sched_t *sched, i2c_dev_t *dev, ds3231_shadow_t *shadow, gpio_num_t pin)
+{
+	CHECK_ARG(sched);
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+
+	memset(sched, 0, sizeof(*sched));
+	sched->dev = dev;
+	sched->shadow = shadow;
+	sched->pin = pin;
+
+	sched->lock = xSemaphoreCreateMutex();
+	if (!sched->lock) return ESP_ERR_NO_MEM;
+
+	/* INT is open drain and active low */
+	gpio_config_t io_conf = {
+		.pin_bit_mask = 1ULL << pin,
+		.mode = GPIO_MODE_INPUT,
+		.pull_up_en = GPIO_PULLUP_ENABLE,
+		.pull_down_en = GPIO_PULLDOWN_DISABLE,
+		.intr_type = GPIO_INTR_LOW_LEVEL,
+	};
+
+	/* no alarm enabled and no stale flag holding INT low */
+	esp_err_t res = ds3231_enable_alarm_ints(dev, shadow, 0);
+	if (res == ESP_OK) res = ds3231_clear_status_flags(dev, shadow, DS3231_STAT_ALARM_1 | DS3231_STAT_ALARM_2);
+	if (res == ESP_OK) res = gpio_config(&io_conf);
+
+	if (res == ESP_OK && xTaskCreate(sched_task, "ds3231_sched", DS3231_SCHED_TASK_STACK, sched, DS3231_SCHED_TASK_PRIORITY, &sched->task) != pdPASS)
+	{
+		sched->task = NULL;
+		res = ESP_ERR_NO_MEM;
+	}
+
+	if (res == ESP_OK)
+	{
+		res = gpio_install_isr_service(0);
+		if (res == ESP_OK || res == ESP_ERR_INVALID_STATE)
+			res = gpio_isr_handler_add(pin, sched_isr, sched);
+	}
+
+	/* free what was created above; the ISR service is shared with other drivers and stays installed */
+	if (res != ESP_OK)
+	{
+		if (sched->task) vTaskDelete(sched->task);
+		vSemaphoreDelete(sched->lock);
+		sched->task = NULL;
+		sched->lock = NULL;
+	}
+
+	return res;
+}
+
+esp_err_t ds3231_sched_add_at(ds3231_sched_t *sched, time_t deadline, uint32_t period,
+		ds3231_timer_cb_t callback, void *arg, int *id)
+{
+	CHECK_ARG(sched);
+	CHECK_ARG(callback);
+
+	time_t now;
+	esp_err_t res = ESP_ERR_NO_MEM;
+
+	xSemaphoreTake(sched->lock, portMAX_DELAY);
+	for (int i = 0; i < DS3231_SCHED_MAX_TIMERS; i++)
+	{
+		ds3231_timer_t *t = &sched->timers[i];
+		if (t->active) continue;
+
+		t->deadline = deadline;
+		t->period = period;
+		t->callback = callback;
+		t->arg = arg;
+		t->active = true;
+		if (id) *id = i;
+
+		/* only touch the alarms if the new deadline may take one of them */
+		res = ESP_OK;
+		if (!sched->armed[0] || !sched->armed[1] || deadline < sched->armed[0] || deadline < sched->armed[1])
+		{
+			res = sched_now(sched, &now);
+			if (res == ESP_OK) res = sched_program(sched, now);
+		}
+		if (res != ESP_OK) t->active = false;
+		break;
+	}
+	xSemaphoreGive(sched->lock);
+
+	return res;
+}
+
+esp_err_t ds3231_sched_add_after(ds3231_sched_t *sched, uint32_t seconds, uint32_t period,
+		ds3231_timer_cb_t callback, void *arg, int *id)
+{
+	CHECK_ARG(sched);
+
+	time_t now;
+	esp_err_t res = sched_now(sched, &now);
+	if (res != ESP_OK) return res;
+
+	return ds3231_sched_add_at(sched, now + seconds, period, callback, arg, id);
+}
+
+esp_err_t ds3231_sched_cancel(ds3231_sched_t *sched, int id)
+{
+	CHECK_ARG(sched);
+	if (id < 0 || id >= DS3231_SCHED_MAX_TIMERS) return ESP_ERR_INVALID_ARG;
+
+	xSemaphoreTake(sched->lock, portMAX_DELAY);
+	sched->timers[id].active = false;
+	xSemaphoreGive(sched->lock);
+
+	/* the alarm may still fire for it; the task then finds nothing expired and reprograms */
+	return ESP_OK;
+}
@@ -0,0 +1,67 @@
+#ifndef MAIN_DS3231_ALARM_H_
+#define MAIN_DS3231_ALARM_H_
+
+#include <time.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+
+#include "ds3231.h"
+
+#define DS3231_SCHED_MAX_TIMERS    16
+#define DS3231_SCHED_TASK_STACK    3072
+#define DS3231_SCHED_TASK_PRIORITY 5
+
+/* after a failed I2C transfer the INT pin stays masked and the task tries again after this delay */
+#define DS3231_SCHED_RETRY_MS      1000
+
+/* alarms match on day of month, so deadlines further away get an intermediate wake-up */
+#define DS3231_SCHED_HORIZON_S     (27 * 24 * 3600)
+
+typedef void (*ds3231_timer_cb_t)(void *arg);
+
+typedef struct {
+	time_t deadline;            // UTC seconds of the next expiry
+	uint32_t period;            // seconds between expiries, 0 for a one-shot timer
+	ds3231_timer_cb_t callback;
+	void *arg;
+	bool active;
+} ds3231_timer_t;
+
+/**
+ * Application timers multiplexed onto the two DS3231 alarms.
+ *
+ * Alarm 1 is always programmed with the earliest deadline; Alarm 2, which has no seconds
+ * register, takes the next one when it falls on a whole minute (or the earliest one, if that
+ * one is minute aligned and the next is not). The INT pin interrupt wakes the scheduler task,
+ * which runs every expired timer and programs the next deadlines. Nothing polls in between.
+ * The alarm interrupt and the square wave share the INT/SQW pin: this mode sets INTCN = 1.
+ */
+typedef struct {
+	i2c_dev_t *dev;
+	ds3231_shadow_t *shadow;
+	gpio_num_t pin;
+	TaskHandle_t task;
+	SemaphoreHandle_t lock;
+
+	ds3231_timer_t timers[DS3231_SCHED_MAX_TIMERS];
+	time_t armed[2];            // deadline in Alarm 1 / Alarm 2, 0 when disabled
+
+	uint32_t interrupts;
+	uint32_t dispatched;
+} ds3231_sched_t;
+
+esp_err_t ds3231_set_alarm1(i2c_dev_t *dev, ds3231_shadow_t *shadow, const struct tm *time);
+esp_err_t ds3231_set_alarm2(i2c_dev_t *dev, ds3231_shadow_t *shadow, const struct tm *time);
+esp_err_t ds3231_enable_alarm_ints(i2c_dev_t *dev, ds3231_shadow_t *shadow, uint8_t alarms);
+
+esp_err_t ds3231_sched_start(ds3231_sched_t *sched, i2c_dev_t *dev, ds3231_shadow_t *shadow, gpio_num_t pin);
+esp_err_t ds3231_sched_add_at(ds3231_sched_t *sched, time_t deadline, uint32_t period,
+		ds3231_timer_cb_t callback, void *arg, int *id);
+esp_err_t ds3231_sched_add_after(ds3231_sched_t *sched, uint32_t seconds, uint32_t period,
+		ds3231_timer_cb_t callback, void *arg, int *id);
+esp_err_t ds3231_sched_cancel(ds3231_sched_t *sched, int id);
+
+#endif /* MAIN_DS3231_ALARM_H_ */
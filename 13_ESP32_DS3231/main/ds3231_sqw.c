@@ -0,0 +1,195 @@
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "ds3231_sqw.h"
+
+#define TAG "DS3231_SQW"
+
+#define CHECK_ARG(ARG) do { if (!ARG) return ESP_ERR_INVALID_ARG; } while (0)
+
+/* the rollover edge must be seen within this time after start, or the pin is not wired */
+#define FIRST_EDGE_TIMEOUT_MS 1500
+
+static void IRAM_ATTR sqw_isr(void *arg)
+{
+	ds3231_sqw_clock_t *clock = (ds3231_sqw_clock_t *)arg;
+	BaseType_t woken = pdFALSE;
+	bool resync = false;
+
+	portENTER_CRITICAL_ISR(&clock->lock);
+	clock->seconds++;
+	clock->edge_us = esp_timer_get_time();
+	clock->edges++;
+	if (clock->until_resync && --clock->until_resync == 0) resync = true;
+	portEXIT_CRITICAL_ISR(&clock->lock);
+
+	/* the task reads the RTC right after the rollover, with almost a whole second of margin */
+	if (resync) vTaskNotifyGiveFromISR(clock->task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+static esp_err_t sqw_resync(ds3231_sqw_clock_t *clock)
+{
+	struct tm time;
+
+	portENTER_CRITICAL(&clock->lock);
+	uint32_t edges = clock->edges;
+	portEXIT_CRITICAL(&clock->lock);
+
+	esp_err_t res = ds3231_get_time(clock->dev, &time);
+	if (res != ESP_OK)
+	{
+		portENTER_CRITICAL(&clock->lock);
+		clock->until_resync = 1;
+		portEXIT_CRITICAL(&clock->lock);
+		return res;
+	}
+	time_t rtc = ds3231_tm_to_epoch(&time);
+
+	/* an edge during the read means the value may belong to either second: retry on the next edge */
+	portENTER_CRITICAL(&clock->lock);
+	bool same_second = clock->edges == edges;
+	time_t ram = clock->seconds;
+	if (same_second)
+	{
+		clock->seconds = rtc;
+		clock->synced = true;
+		clock->until_resync = clock->resync_interval;
+	}
+	else clock->until_resync = 1;
+	portEXIT_CRITICAL(&clock->lock);
+
+	if (!same_second) return ESP_ERR_INVALID_STATE;
+
+	clock->resyncs++;
+	if (clock->resyncs > 1 && ram != rtc)
+	{
+		clock->corrections++;
+		ESP_LOGW(TAG, "RAM time off by %lld s, corrected", (long long)(ram - rtc));
+	}
+	return ESP_OK;
+}
+
+static void sqw_task(void *arg)
+{
+	ds3231_sqw_clock_t *clock = (ds3231_sqw_clock_t *)arg;
+
+	while (1)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		esp_err_t res = sqw_resync(clock);
+		if (res != ESP_OK && res != ESP_ERR_INVALID_STATE)
+			ESP_LOGE(TAG, "Resync failed: %s", esp_err_to_name(res));
+	}
+}
+
+esp_err_t ds3231_sqw_clock_start(ds3231_sqw_clock_t *clock, i2c_dev_t *dev, ds3231_shadow_t *shadow,
+		gpio_num_t pin, uint32_t resync_interval)
+{
+	CHECK_ARG(clock);
+	CHECK_ARG(dev);
+	CHECK_ARG(shadow);
+	CHECK_ARG(resync_interval);
+
+	memset(clock, 0, sizeof(*clock));
+	portMUX_INITIALIZE(&clock->lock);
+	clock->dev = dev;
+	clock->shadow = shadow;
+	clock->pin = pin;
+	clock->resync_interval = resync_interval;
+	clock->until_resync = 1; /* read the RTC right after the first edge */
+
+	esp_err_t res = ds3231_enable_squarewave(dev, shadow, DS3231_SQW_1HZ);
+	if (res != ESP_OK) return res;
+
+	/* INT/SQW is open drain; the seconds register increments on the falling edge */
+	gpio_config_t io_conf = {
+		.pin_bit_mask = 1ULL << pin,
+		.mode = GPIO_MODE_INPUT,
+		.pull_up_en = GPIO_PULLUP_ENABLE,
+		.pull_down_en = GPIO_PULLDOWN_DISABLE,
+		.intr_type = GPIO_INTR_NEGEDGE,
+	};
+	res = gpio_config(&io_conf);
+	if (res != ESP_OK) return res;
+
+	if (xTaskCreate(sqw_task, "ds3231_sqw", DS3231_SQW_TASK_STACK, clock, DS3231_SQW_TASK_PRIORITY, &clock->task) != pdPASS)
+		return ESP_ERR_NO_MEM;
+
+	res = gpio_install_isr_service(0);
+	if (res == ESP_OK || res == ESP_ERR_INVALID_STATE)
+		res = gpio_isr_handler_add(pin, sqw_isr, clock);
+	if (res != ESP_OK)
+	{
+		vTaskDelete(clock->task);
+		return res;
+	}
+
+	/* wait for the first edge and the initial read */
+	int64_t start = esp_timer_get_time();
+	while (esp_timer_get_time() - start < FIRST_EDGE_TIMEOUT_MS * 1000LL)
+	{
+		vTaskDelay(1);
+		portENTER_CRITICAL(&clock->lock);
+		bool synced = clock->synced;
+		portEXIT_CRITICAL(&clock->lock);
+		if (synced) return ESP_OK;
+	}
+
+	ESP_LOGE(TAG, "No square wave on GPIO %d", pin);
+	ds3231_sqw_clock_stop(clock);
+	return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t ds3231_sqw_clock_stop(ds3231_sqw_clock_t *clock)
+{
+	CHECK_ARG(clock);
+
+	gpio_isr_handler_remove(clock->pin);
+	if (clock->task)
+	{
+		vTaskDelete(clock->task);
+		clock->task = NULL;
+	}
+	clock->synced = false;
+	return ESP_OK;
+}
+
+esp_err_t ds3231_sqw_clock_now(ds3231_sqw_clock_t *clock, time_t *seconds, uint32_t *usec)
+{
+	CHECK_ARG(clock);
+	CHECK_ARG(seconds);
+
+	portENTER_CRITICAL(&clock->lock);
+	bool synced = clock->synced;
+	*seconds = clock->seconds;
+	int64_t edge_us = clock->edge_us;
+	portEXIT_CRITICAL(&clock->lock);
+
+	if (!synced) return ESP_ERR_INVALID_STATE;
+
+	if (usec)
+	{
+		/* time since the rollover, capped in case an edge is late */
+		int64_t elapsed = esp_timer_get_time() - edge_us;
+		*usec = elapsed < 0 ? 0 : elapsed > 999999 ? 999999 : (uint32_t)elapsed;
+	}
+	return ESP_OK;
+}
+
+esp_err_t ds3231_sqw_clock_get_time(ds3231_sqw_clock_t *clock, struct tm *time)
+{
+	CHECK_ARG(time);
+
+	time_t seconds;
+	esp_err_t res = ds3231_sqw_clock_now(clock, &seconds, NULL);
+	if (res == ESP_OK)
+		gmtime_r(&seconds, time);
+
+	return res;
+}
@@ -0,0 +1,49 @@
+#ifndef MAIN_DS3231_SQW_H_
+#define MAIN_DS3231_SQW_H_
+
+#include <time.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+
+#include "ds3231.h"
+
+#define DS3231_SQW_TASK_STACK    3072
+#define DS3231_SQW_TASK_PRIORITY 5
+
+/**
+ * Time kept in RAM and advanced by the 1 Hz square wave of the DS3231.
+ *
+ * The RTC is read over I2C once at start and then only every resync_interval seconds;
+ * between resyncs each falling edge of INT/SQW (seconds rollover) adds one second in the
+ * GPIO ISR, so reading the time is a memory access instead of a bus transaction.
+ * The square wave and the alarm interrupt share the INT/SQW pin: this mode leaves INTCN = 0.
+ */
+typedef struct {
+	i2c_dev_t *dev;
+	ds3231_shadow_t *shadow;
+	gpio_num_t pin;
+	uint32_t resync_interval;   // seconds between I2C resyncs
+	TaskHandle_t task;
+	portMUX_TYPE lock;
+
+	/* written by the ISR, protected by lock */
+	time_t seconds;             // UTC seconds of the current second
+	int64_t edge_us;            // esp_timer time of the last edge
+	uint32_t edges;             // edges counted since start
+	uint32_t until_resync;      // edges left before the next resync
+	bool synced;                // seconds holds a value read from the RTC
+
+	/* statistics */
+	uint32_t resyncs;
+	uint32_t corrections;       // resyncs that found the RAM time off
+} ds3231_sqw_clock_t;
+
+esp_err_t ds3231_sqw_clock_start(ds3231_sqw_clock_t *clock, i2c_dev_t *dev, ds3231_shadow_t *shadow,
+		gpio_num_t pin, uint32_t resync_interval);
+esp_err_t ds3231_sqw_clock_stop(ds3231_sqw_clock_t *clock);
+esp_err_t ds3231_sqw_clock_now(ds3231_sqw_clock_t *clock, time_t *seconds, uint32_t *usec);
+esp_err_t ds3231_sqw_clock_get_time(ds3231_sqw_clock_t *clock, struct tm *time);
+
+#endif /* MAIN_DS3231_SQW_H_ */
@@ -1,49 +1,591 @@
 #include <string.h>
 #include <time.h>
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 #include "esp_err.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #define TAG "I2C"
 
+typedef struct {
+	i2c_master_bus_handle_t handle;
+	SemaphoreHandle_t mutex;	// recursive, held for every transaction on the port
+	int sda;
+	int scl;
+	int users;
+	i2c_dev_t *devices[I2C_BUS_MAX_DEVICES];	// added back after a controller reinit
+	i2c_bus_recovery_stats_t recovery;
+} i2c_bus_t;
+
+static i2c_bus_t buses[I2C_NUM_MAX];
+
+/* guards the bus table; created on first use so any task may acquire a port */
+static SemaphoreHandle_t table_lock(void)
+{
+	static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+	static StaticSemaphore_t buf;
+	static SemaphoreHandle_t lock;
+
+	portENTER_CRITICAL(&mux);
+	if (!lock) lock = xSemaphoreCreateMutexStatic(&buf);
+	portEXIT_CRITICAL(&mux);
+
+	return lock;
+}
+
+static bool port_valid(i2c_port_t port)
+{
+	return port >= 0 && port < I2C_NUM_MAX;
+}
+
+static esp_err_t new_bus(i2c_port_t port, int sda, int scl, i2c_master_bus_handle_t *handle)
+{
+	i2c_master_bus_config_t bus_config = {
+		.i2c_port = port,
+		.sda_io_num = sda,
+		.scl_io_num = scl,
+		.clk_source = I2C_CLK_SRC_DEFAULT,
+		.glitch_ignore_cnt = 7,
+		.flags.enable_internal_pullup = true,
+	};
+	return i2c_new_master_bus(&bus_config, handle);
+}
+
+static esp_err_t add_device(i2c_port_t port, uint8_t addr, uint32_t clk_speed, i2c_master_dev_handle_t *handle)
+{
+	i2c_device_config_t dev_config = {
+		.dev_addr_length = I2C_ADDR_BIT_7,
+		.device_address = addr,
+		.scl_speed_hz = clk_speed ? clk_speed : I2C_FREQ_HZ,
+	};
+	return i2c_master_bus_add_device(buses[port].handle, &dev_config, handle);
+}
+
+esp_err_t i2c_bus_acquire(i2c_port_t port, int sda, int scl)
+{
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+
+	i2c_bus_t *bus = &buses[port];
+	esp_err_t res = ESP_OK;
+
+	xSemaphoreTake(table_lock(), portMAX_DELAY);
+	if (bus->users)
+	{
+		if (bus->sda != sda || bus->scl != scl)
+		{
+			ESP_LOGE(TAG, "Port %d already in use on SDA %d / SCL %d", port, bus->sda, bus->scl);
+			res = ESP_ERR_INVALID_STATE;
+		}
+	}
+	else
+	{
+		if (!bus->mutex) bus->mutex = xSemaphoreCreateRecursiveMutex();
+		if (!bus->mutex) res = ESP_ERR_NO_MEM;
+		if (res == ESP_OK) res = new_bus(port, sda, scl, &bus->handle);
+		if (res == ESP_OK)
+		{
+			bus->sda = sda;
+			bus->scl = scl;
+		}
+	}
+	if (res == ESP_OK) bus->users++;
+	xSemaphoreGive(table_lock());
+
+	return res;
+}
+
+esp_err_t i2c_bus_release(i2c_port_t port)
+{
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+
+	i2c_bus_t *bus = &buses[port];
+	esp_err_t res = ESP_OK;
+
+	xSemaphoreTake(table_lock(), portMAX_DELAY);
+	if (!bus->users) res = ESP_ERR_INVALID_STATE;
+	else if (bus->users == 1 && bus->handle)
+	{
+		/* the mutex is kept: a task may still be waiting on it */
+		res = i2c_del_master_bus(bus->handle);
+		if (res == ESP_OK) bus->handle = NULL;
+	}
+	if (res == ESP_OK) bus->users--;
+	xSemaphoreGive(table_lock());
+
+	return res;
+}
+
+esp_err_t i2c_bus_get_handle(i2c_port_t port, i2c_master_bus_handle_t *handle)
+{
+	if (!port_valid(port) || !handle) return ESP_ERR_INVALID_ARG;
+	if (!buses[port].handle) return ESP_ERR_INVALID_STATE;
+
+	*handle = buses[port].handle;
+	return ESP_OK;
+}
+
+esp_err_t i2c_bus_lock(i2c_port_t port)
+{
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+	if (!buses[port].mutex) return ESP_ERR_INVALID_STATE;
+
+	if (xSemaphoreTakeRecursive(buses[port].mutex, pdMS_TO_TICKS(I2CDEV_TIMEOUT)) != pdTRUE)
+	{
+		ESP_LOGE(TAG, "Could not take the mutex of port %d", port);
+		return ESP_ERR_TIMEOUT;
+	}
+	return ESP_OK;
+}
+
+esp_err_t i2c_bus_unlock(i2c_port_t port)
+{
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+	if (!buses[port].mutex) return ESP_ERR_INVALID_STATE;
+
+	return xSemaphoreGiveRecursive(buses[port].mutex) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+/* a NACK: ESP_ERR_INVALID_STATE, or ESP_FAIL from older driver releases */
+static bool is_nack(esp_err_t res)
+{
+	return res == ESP_ERR_INVALID_STATE || res == ESP_FAIL;
+}
+
+/* called with the port mutex held */
+static bool registered(const i2c_dev_t *dev)
+{
+	for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++)
+		if (buses[dev->port].devices[i] == dev) return true;
+	return false;
+}
+
+/* called with the port mutex held; false after a reinit that failed half way */
+static bool bus_complete(const i2c_bus_t *bus)
+{
+	if (!bus->handle) return false;
+	for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++)
+		if (bus->devices[i] && !bus->devices[i]->handle) return false;
+	return true;
+}
+
+/* called with the port mutex held */
+static esp_err_t reinit_bus(i2c_port_t port)
+{
+	i2c_bus_t *bus = &buses[port];
+	esp_err_t res = ESP_OK;
+
+	/* an earlier failed reinit may have left the bus, or some devices, already removed */
+	if (bus->handle)
+	{
+		for (int i = 0; i < I2C_BUS_MAX_DEVICES && res == ESP_OK; i++)
+		{
+			if (!bus->devices[i] || !bus->devices[i]->handle) continue;
+			res = i2c_master_bus_rm_device(bus->devices[i]->handle);
+			if (res == ESP_OK) bus->devices[i]->handle = NULL;
+		}
+		if (res == ESP_OK) res = i2c_del_master_bus(bus->handle);
+		if (res != ESP_OK) return res;
+		bus->handle = NULL;
+	}
+
+	bus->recovery.reinits++;
+	res = new_bus(port, bus->sda, bus->scl, &bus->handle);
+	if (res != ESP_OK) bus->handle = NULL;
+
+	for (int i = 0; i < I2C_BUS_MAX_DEVICES && res == ESP_OK; i++)
+	{
+		i2c_dev_t *dev = bus->devices[i];
+		if (dev) res = add_device(port, dev->addr, dev->clk_speed, &dev->handle);
+	}
+	return res;
+}
+
+esp_err_t i2c_bus_recover(i2c_port_t port)
+{
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+
+	esp_err_t res = i2c_bus_lock(port);
+	if (res != ESP_OK) return res;
+
+	i2c_bus_t *bus = &buses[port];
+	if (!bus->users)
+	{
+		i2c_bus_unlock(port);
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	if (bus_complete(bus))
+	{
+		/* up to 9 SCL pulses until the slave releases SDA, then a STOP, and the controller FSM reset */
+		bus->recovery.bus_resets++;
+		res = i2c_master_bus_reset(bus->handle);
+		if (res != ESP_OK)
+		{
+			ESP_LOGW(TAG, "Bus reset of port %d failed (%d), reinitializing the controller", port, res);
+			res = reinit_bus(port);
+		}
+	}
+	else
+	{
+		/* the last reinit failed: the bus or some devices are missing, create them again */
+		res = reinit_bus(port);
+	}
+	if (res != ESP_OK)
+	{
+		bus->recovery.failures++;
+		ESP_LOGE(TAG, "Could not recover port %d: %d", port, res);
+	}
+	i2c_bus_unlock(port);
+
+	return res;
+}
+
+esp_err_t i2c_bus_get_recovery_stats(i2c_port_t port, i2c_bus_recovery_stats_t *stats)
+{
+	if (!port_valid(port) || !stats) return ESP_ERR_INVALID_ARG;
+
+	*stats = buses[port].recovery;
+	return ESP_OK;
+}
+
+#if I2C_DEV_STATS
+static const uint32_t bucket_limits_us[I2C_STATS_BUCKETS - 1] = { 100, 200, 500, 1000, 2000, 5000, 10000 };
+
+static i2c_dev_stats_t stats[I2C_STATS_MAX_DEVICES];
+static int stats_count;
+#if I2C_TRACE_LEN
+static i2c_trace_entry_t trace[I2C_TRACE_LEN];
+static uint32_t trace_next;		// total entries written; the oldest is overwritten
+#endif
+/* counters are updated from any task, for any port: a short critical section is enough */
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* called with stats_mux held */
+static i2c_dev_stats_t *stats_find(i2c_port_t port, uint16_t addr, bool create)
+{
+	for (int i = 0; i < stats_count; i++)
+		if (stats[i].port == port && stats[i].addr == addr) return &stats[i];
+
+	if (!create || stats_count == I2C_STATS_MAX_DEVICES) return NULL;
+
+	i2c_dev_stats_t *st = &stats[stats_count++];
+	memset(st, 0, sizeof(*st));
+	st->port = port;
+	st->addr = addr;
+	st->min_us = UINT32_MAX;
+	return st;
+}
+#endif
+
+void i2c_stats_record(i2c_port_t port, uint16_t addr, i2c_dir_t dir, uint8_t reg, size_t len, int64_t start_us, esp_err_t res)
+{
+#if I2C_DEV_STATS
+	uint32_t duration = (uint32_t)(esp_timer_get_time() - start_us);
+	int bucket = 0;
+	while (bucket < I2C_STATS_BUCKETS - 1 && duration >= bucket_limits_us[bucket]) bucket++;
+
+	portENTER_CRITICAL(&stats_mux);
+	i2c_dev_stats_t *st = stats_find(port, addr, true);
+	if (st)
+	{
+		if (dir == I2C_DIR_READ) { st->reads++; if (res == ESP_OK) st->bytes_read += len; }
+		else { st->writes++; if (res == ESP_OK) st->bytes_written += len; }
+
+		/* same classification as transfer(): only a timeout leads to a bus recovery */
+		if (is_nack(res)) st->nacks++;
+		else if (res == ESP_ERR_TIMEOUT) st->timeouts++;
+		else if (res != ESP_OK) st->errors++;
+
+		if (duration < st->min_us) st->min_us = duration;
+		if (duration > st->max_us) st->max_us = duration;
+		st->total_us += duration;
+		st->histogram[bucket]++;
+	}
+#if I2C_TRACE_LEN
+	i2c_trace_entry_t *e = &trace[trace_next++ % I2C_TRACE_LEN];
+	e->start_us = start_us;
+	e->duration_us = duration;
+	e->result = res;
+	e->len = len;
+	e->port = port;
+	e->addr = addr;
+	e->reg = reg;
+	e->dir = dir;
+#endif
+	portEXIT_CRITICAL(&stats_mux);
+#endif
+}
+
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *out)
+{
+	if (!dev || !out) return ESP_ERR_INVALID_ARG;
+#if I2C_DEV_STATS
+	esp_err_t res = ESP_ERR_NOT_FOUND;
+
+	portENTER_CRITICAL(&stats_mux);
+	i2c_dev_stats_t *st = stats_find(dev->port, dev->addr, false);
+	if (st)
+	{
+		*out = *st;
+		res = ESP_OK;
+	}
+	portEXIT_CRITICAL(&stats_mux);
+
+	return res;
+#else
+	return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void i2c_stats_reset(void)
+{
+#if I2C_DEV_STATS
+	portENTER_CRITICAL(&stats_mux);
+	stats_count = 0;
+#if I2C_TRACE_LEN
+	trace_next = 0;
+#endif
+	portEXIT_CRITICAL(&stats_mux);
+#endif
+}
+
+void i2c_stats_dump(void)
+{
+	for (int port = 0; port < I2C_NUM_MAX; port++)
+	{
+		const i2c_bus_recovery_stats_t *r = &buses[port].recovery;
+		if (!buses[port].users) continue;
+		ESP_LOGI(TAG, "Port %d: %lu retries, %lu recovered, %lu bus resets, %lu reinits, %lu failed recoveries",
+				port, (unsigned long)r->retries, (unsigned long)r->recovered, (unsigned long)r->bus_resets,
+				(unsigned long)r->reinits, (unsigned long)r->failures);
+	}
+#if I2C_DEV_STATS
+	for (int i = 0; i < I2C_STATS_MAX_DEVICES; i++)
+	{
+		/* copy out of the critical section: logging is slow */
+		i2c_dev_stats_t st;
+		portENTER_CRITICAL(&stats_mux);
+		bool valid = i < stats_count;
+		if (valid) st = stats[i];
+		portEXIT_CRITICAL(&stats_mux);
+		if (!valid) break;
+
+		uint32_t count = st.reads + st.writes;
+		ESP_LOGI(TAG, "[0x%02x at %d] %lu reads (%lu B), %lu writes (%lu B), %lu NACK, %lu timeouts, %lu errors",
+				st.addr, st.port, (unsigned long)st.reads, (unsigned long)st.bytes_read,
+				(unsigned long)st.writes, (unsigned long)st.bytes_written,
+				(unsigned long)st.nacks, (unsigned long)st.timeouts, (unsigned long)st.errors);
+		if (!count) continue;
+		ESP_LOGI(TAG, "[0x%02x at %d] latency min %lu us, avg %lu us, max %lu us",
+				st.addr, st.port, (unsigned long)st.min_us, (unsigned long)(st.total_us / count), (unsigned long)st.max_us);
+		ESP_LOGI(TAG, "[0x%02x at %d] <100:%lu <200:%lu <500:%lu <1ms:%lu <2ms:%lu <5ms:%lu <10ms:%lu >=10ms:%lu",
+				st.addr, st.port, (unsigned long)st.histogram[0], (unsigned long)st.histogram[1],
+				(unsigned long)st.histogram[2], (unsigned long)st.histogram[3], (unsigned long)st.histogram[4],
+				(unsigned long)st.histogram[5], (unsigned long)st.histogram[6], (unsigned long)st.histogram[7]);
+	}
+#endif
+}
+
+void i2c_trace_dump(void)
+{
+#if I2C_DEV_STATS && I2C_TRACE_LEN
+	/* static to keep it off the caller stack: dump from one task at a time */
+	static i2c_trace_entry_t copy[I2C_TRACE_LEN];
+
+	portENTER_CRITICAL(&stats_mux);
+	uint32_t end = trace_next;
+	memcpy(copy, trace, sizeof(copy));
+	portEXIT_CRITICAL(&stats_mux);
+
+	uint32_t first = end > I2C_TRACE_LEN ? end - I2C_TRACE_LEN : 0;
+	for (uint32_t n = first; n < end; n++)
+	{
+		const i2c_trace_entry_t *e = &copy[n % I2C_TRACE_LEN];
+		ESP_LOGI(TAG, "%lld us: %s [0x%02x at %d] reg 0x%02x, %u B, %lu us, %s", (long long)e->start_us,
+				e->dir == I2C_DIR_READ ? "read " : "write", e->addr, e->port, e->reg, e->len,
+				(unsigned long)e->duration_us, esp_err_to_name(e->result));
+	}
+#endif
+}
+
 esp_err_t i2c_dev_init(i2c_port_t port, int sda, int scl)
 {
-    i2c_config_t i2c_config = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = sda,
-        .scl_io_num = scl,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_FREQ_HZ
-    };
-    i2c_param_config(port, &i2c_config); 
-    return i2c_driver_install(port, I2C_MODE_MASTER, 0, 0, 0);
+	/* only validates: the bus reference is taken by i2c_dev_create() and dropped by i2c_dev_delete() */
+	if (!port_valid(port)) return ESP_ERR_INVALID_ARG;
+
+	esp_err_t res = ESP_OK;
+	xSemaphoreTake(table_lock(), portMAX_DELAY);
+	if (buses[port].users && (buses[port].sda != sda || buses[port].scl != scl))
+	{
+		ESP_LOGE(TAG, "Port %d already in use on SDA %d / SCL %d", port, buses[port].sda, buses[port].scl);
+		res = ESP_ERR_INVALID_STATE;
+	}
+	xSemaphoreGive(table_lock());
+
+	return res;
 }
 
-esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+esp_err_t i2c_dev_create(i2c_dev_t *dev)
 {
-	if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+	if (!dev || !port_valid(dev->port)) return ESP_ERR_INVALID_ARG;
+
+	/* every device holds a reference on its port; the port mutex only exists once it is taken */
+	esp_err_t res = i2c_bus_acquire(dev->port, dev->sda_io_num, dev->scl_io_num);
+	if (res != ESP_OK) return res;
 
-	i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-	if (out_data && out_size)
+	/* not I2C_DEV_TAKE: a failed lock must drop the reference taken above */
+	bool added = false;
+	res = i2c_bus_lock(dev->port);
+	if (res == ESP_OK)
 	{
-		i2c_master_start(cmd);
-		i2c_master_write_byte(cmd, (dev->addr << 1) | I2C_MASTER_WRITE, true);
-		i2c_master_write(cmd, (void *)out_data, out_size, true);
+		/* checked under the lock, so two concurrent calls cannot both add the device */
+		if (!dev->handle && !registered(dev))
+		{
+			i2c_bus_t *bus = &buses[dev->port];
+			int slot = 0;
+			while (slot < I2C_BUS_MAX_DEVICES && bus->devices[slot]) slot++;
+
+			if (slot == I2C_BUS_MAX_DEVICES) res = ESP_ERR_NO_MEM;
+			else res = add_device(dev->port, dev->addr, dev->clk_speed, &dev->handle);
+			if (res == ESP_OK)
+			{
+				bus->devices[slot] = dev;
+				added = true;
+			}
+		}
+		/* else already created; a registered device without handle is added back by the next recovery */
+		I2C_DEV_GIVE(dev);
 	}
-	i2c_master_start(cmd);
-	i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
-	i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
-	i2c_master_stop(cmd);
 
-	esp_err_t res = i2c_master_cmd_begin(dev->port, cmd, I2CDEV_TIMEOUT / portTICK_PERIOD_MS);
+	if (res != ESP_OK)
+		ESP_LOGE(TAG, "Could not add device [0x%02x at %d]: %d", dev->addr, dev->port, res);
+	/* the device keeps only the reference taken when it was added */
+	if (!added)
+		i2c_bus_release(dev->port);
+
+	return res;
+}
+
+esp_err_t i2c_dev_delete(i2c_dev_t *dev)
+{
+	if (!dev || !port_valid(dev->port)) return ESP_ERR_INVALID_ARG;
+	/* the port mutex is created with the first reference and never freed: no mutex, no device */
+	if (!buses[dev->port].mutex) return ESP_OK;
+
+	/* the handle may be missing after a failed recovery; the bus reference is still held */
+	I2C_DEV_TAKE(dev);
+	bool known = dev->handle || registered(dev);
+	esp_err_t res = dev->handle ? i2c_master_bus_rm_device(dev->handle) : ESP_OK;
+	if (known && res == ESP_OK)
+	{
+		dev->handle = NULL;
+		for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++)
+			if (buses[dev->port].devices[i] == dev) buses[dev->port].devices[i] = NULL;
+	}
+	I2C_DEV_GIVE(dev);
+
+	if (known && res == ESP_OK) res = i2c_bus_release(dev->port);
+
+	return res;
+}
+
+esp_err_t i2c_dev_set_speed(i2c_dev_t *dev, uint32_t clk_speed)
+{
+	if (!dev || !clk_speed) return ESP_ERR_INVALID_ARG;
+	if (!dev->handle)
+	{
+		dev->clk_speed = clk_speed;
+		return ESP_OK;
+	}
+	if (dev->clk_speed == clk_speed) return ESP_OK;
+
+	/* the speed is part of the device configuration: add the device again */
+	I2C_DEV_TAKE(dev);
+	esp_err_t res = i2c_master_bus_rm_device(dev->handle);
+	if (res == ESP_OK)
+	{
+		dev->handle = NULL;
+		res = add_device(dev->port, dev->addr, clk_speed, &dev->handle);
+	}
+	if (res == ESP_OK) dev->clk_speed = clk_speed;
+	I2C_DEV_GIVE(dev);
+
+	return res;
+}
+
+/*
+ * Runs one transaction: a read when in_data is set (write of out, repeated START, read),
+ * otherwise a write of out. A timeout or bus error, the sign of a stuck bus, triggers a bus
+ * recovery and is retried with a doubling backoff. A NACK usually means the device is absent,
+ * so it is retried only I2CDEV_NACK_RETRIES times, without waiting. A device left without
+ * handle by a failed recovery gets another recovery attempt instead of failing for good.
+ */
+static esp_err_t transfer(const i2c_dev_t *dev, const uint8_t *out, size_t out_size, uint8_t *in, size_t in_size)
+{
+	i2c_bus_recovery_stats_t *recovery = &buses[dev->port].recovery;
+	uint32_t backoff = I2CDEV_BACKOFF_MS;
+	int nack_retries = 0;
+	esp_err_t res;
+
+	for (int attempt = 0; ; attempt++)
+	{
+		I2C_DEV_TAKE(dev);
+		bool known = registered(dev);
+		if (!dev->handle && known) i2c_bus_recover(dev->port);
+
+		/* a controller reinit replaces the handle */
+		i2c_master_dev_handle_t handle = dev->handle;
+		if (!handle)
+		{
+			/* still no bus: counts as a bus error, so it is retried after the backoff */
+			res = known ? I2CDEV_ERR_NO_BUS : ESP_ERR_INVALID_STATE;
+			if (known)
+				i2c_stats_record(dev->port, dev->addr, in ? I2C_DIR_READ : I2C_DIR_WRITE, out_size ? out[0] : 0,
+						in ? in_size : out_size, esp_timer_get_time(), res);
+		}
+		else
+		{
+			int64_t start = esp_timer_get_time();
+			if (in && out_size)
+				res = i2c_master_transmit_receive(handle, out, out_size, in, in_size, I2CDEV_TIMEOUT);
+			else if (in)
+				res = i2c_master_receive(handle, in, in_size, I2CDEV_TIMEOUT);
+			else
+				res = i2c_master_transmit(handle, out, out_size, I2CDEV_TIMEOUT);
+			i2c_stats_record(dev->port, dev->addr, in ? I2C_DIR_READ : I2C_DIR_WRITE, out_size ? out[0] : 0,
+					in ? in_size : out_size, start, res);
+			if (res == ESP_ERR_TIMEOUT) i2c_bus_recover(dev->port);
+		}
+		if (res == ESP_OK && attempt) recovery->recovered++;
+
+		bool nack = handle && is_nack(res);
+		bool retry = attempt < I2CDEV_MAX_RETRIES &&
+				(res == ESP_ERR_TIMEOUT || res == I2CDEV_ERR_NO_BUS || (nack && nack_retries++ < I2CDEV_NACK_RETRIES));
+		if (retry) recovery->retries++;
+		I2C_DEV_GIVE(dev);
+
+		if (!retry) break;
+		if (nack) continue;
+
+		vTaskDelay(pdMS_TO_TICKS(backoff));
+		backoff = backoff * 2 > I2CDEV_BACKOFF_MAX_MS ? I2CDEV_BACKOFF_MAX_MS : backoff * 2;
+	}
+	return res;
+}
+
+esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+{
+	if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+	if (!out_data) out_size = 0;
+
+	esp_err_t res = transfer(dev, out_data, out_size, in_data, in_size);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d", dev->addr, dev->port, res);
-	i2c_cmd_link_delete(cmd);
 
 	return res;
 }
@@ -51,18 +593,17 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_si
 esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
 {
 	if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
+	if (!out_reg) out_reg_size = 0;
+	if (out_reg_size + out_size > I2CDEV_MAX_WRITE) return ESP_ERR_INVALID_SIZE;
 
-	i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-	i2c_master_start(cmd);
-	i2c_master_write_byte(cmd, (dev->addr << 1) | I2C_MASTER_WRITE, true);
-	if (out_reg && out_reg_size)
-		i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
-	i2c_master_write(cmd, (void *)out_data, out_size, true);
-	i2c_master_stop(cmd);
-	esp_err_t res = i2c_master_cmd_begin(dev->port, cmd, I2CDEV_TIMEOUT / portTICK_PERIOD_MS);
+	/* the register address and the data go out as one buffer, built on the stack */
+	uint8_t buf[I2CDEV_MAX_WRITE];
+	if (out_reg_size) memcpy(buf, out_reg, out_reg_size);
+	memcpy(buf + out_reg_size, out_data, out_size);
+
+	esp_err_t res = transfer(dev, buf, out_reg_size + out_size, NULL, 0);
 	if (res != ESP_OK)
 		ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d", dev->addr, dev->port, res);
-	i2c_cmd_link_delete(cmd);
 
 	return res;
 }
@@ -75,4 +616,4 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, siz
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
 {
 	return i2c_dev_write(dev, &reg, 1, out_data, out_size);
-}
\ No newline at end of file
+}
@@ -1,23 +1,138 @@
 #ifndef MAIN_I2C_H_
 #define MAIN_I2C_H_
 
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
 
 #define I2C_FREQ_HZ 400000
 #define I2CDEV_TIMEOUT 1000
 
+/* register address plus data of the largest write, assembled on the stack */
+#define I2CDEV_MAX_WRITE 32
+
+/* a timeout or bus error is retried up to I2CDEV_MAX_RETRIES times, waiting
+ * I2CDEV_BACKOFF_MS before the first retry and doubling up to I2CDEV_BACKOFF_MAX_MS;
+ * a NACK is retried I2CDEV_NACK_RETRIES times, right away */
+#define I2CDEV_MAX_RETRIES 3
+#define I2CDEV_NACK_RETRIES 1
+#define I2CDEV_BACKOFF_MS 5
+#define I2CDEV_BACKOFF_MAX_MS 40
+
+/* returned when a failed recovery left the port without a bus; retried like a bus error */
+#define I2CDEV_ERR_NO_BUS ESP_ERR_NOT_FINISHED
+
+/* devices per port that the bus manager can add back after reinitializing the controller */
+#define I2C_BUS_MAX_DEVICES 8
+
+/**
+ * Bus recovery counters of one port.
+ * A timeout means the bus may be stuck (a slave holding SDA low after a glitch): the bus is
+ * reset, clocking out up to 9 SCL pulses and a STOP. If that fails the controller is
+ * reinitialized and the devices added again.
+ */
+typedef struct {
+	uint32_t retries;		// transactions attempted again after a failure
+	uint32_t recovered;		// transactions that succeeded on a retry
+	uint32_t bus_resets;
+	uint32_t reinits;		// controller deleted and created again
+	uint32_t failures;		// recoveries that could not bring the bus back
+} i2c_bus_recovery_stats_t;
+
+/* per-device counters and latency histograms; cheap enough to stay enabled in production */
+#define I2C_DEV_STATS 1
+#define I2C_STATS_MAX_DEVICES 8
+#define I2C_STATS_BUCKETS 8
+
+/* ring buffer of the most recent transactions, 0 to leave it out */
+#define I2C_TRACE_LEN 32
+
+typedef enum {
+	I2C_DIR_READ,
+	I2C_DIR_WRITE,
+} i2c_dir_t;
+
+/**
+ * Transaction statistics of one device.
+ * Bucket i of the latency histogram counts transactions below 100, 200, 500, 1000, 2000,
+ * 5000 and 10000 us; the last one the rest. A NACK is reported by the driver as
+ * ESP_ERR_INVALID_STATE (ESP_FAIL on older releases); both are handled as a NACK.
+ */
+typedef struct {
+	i2c_port_t port;
+	uint16_t addr;
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+	uint32_t nacks;
+	uint32_t timeouts;
+	uint32_t errors;		// any other failure, e.g. I2CDEV_ERR_NO_BUS
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint32_t histogram[I2C_STATS_BUCKETS];
+} i2c_dev_stats_t;
+
+typedef struct {
+	int64_t start_us;		// esp_timer time at which the transaction started
+	uint32_t duration_us;
+	esp_err_t result;
+	uint16_t len;
+	uint8_t port;
+	uint8_t addr;
+	uint8_t reg;			// first byte written (the register address), 0 for plain reads
+	uint8_t dir;			// i2c_dir_t
+} i2c_trace_entry_t;
+
 typedef struct {
 	i2c_port_t port;	    // I2C port number
 	uint8_t addr;		    // I2C address
 	gpio_num_t sda_io_num;	// GPIO number for I2C sda signal
 	gpio_num_t scl_io_num;	// GPIO number for I2C scl signal
 	uint32_t clk_speed;		// I2C clock frequency for master mode
+	i2c_master_dev_handle_t handle;	// device on the bus, created once by i2c_dev_create()
 } i2c_dev_t;
 
+/**
+ * Bus manager: each I2C port is owned by the manager and shared by every driver that uses it.
+ *
+ * i2c_bus_acquire() creates the master bus on first use and counts the users; the pins must
+ * match those of the first user. Each device keeps its own SCL speed (the controller is
+ * reclocked per transaction). Every transaction runs with the port mutex held; drivers take it
+ * with i2c_bus_lock() around sequences that must not interleave with other tasks, such as a
+ * read-modify-write of a register. The mutex is recursive, so i2c_dev_* calls nest inside.
+ * Drivers with their own device handling (i2c_lcd.c, ssd1306.c) add their devices to the
+ * handle returned by i2c_bus_get_handle() and wrap their transfers in i2c_bus_lock(); they
+ * must remove their devices for a controller reinitialization to succeed.
+ */
+esp_err_t i2c_bus_acquire(i2c_port_t port, int sda, int scl);
+esp_err_t i2c_bus_release(i2c_port_t port);
+esp_err_t i2c_bus_get_handle(i2c_port_t port, i2c_master_bus_handle_t *bus);
+esp_err_t i2c_bus_lock(i2c_port_t port);
+esp_err_t i2c_bus_unlock(i2c_port_t port);
+esp_err_t i2c_bus_recover(i2c_port_t port);
+esp_err_t i2c_bus_get_recovery_stats(i2c_port_t port, i2c_bus_recovery_stats_t *stats);
+
+/* i2c_dev_init() only checks the port and pins; i2c_dev_create() holds the bus reference of the device */
 esp_err_t i2c_dev_init(i2c_port_t port, int sda, int scl);
+esp_err_t i2c_dev_create(i2c_dev_t *dev);
+esp_err_t i2c_dev_delete(i2c_dev_t *dev);
+esp_err_t i2c_dev_set_speed(i2c_dev_t *dev, uint32_t clk_speed);
 esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size);
 esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size);
 esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size);
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size);
 
-#endif /* I2C_H_ */
\ No newline at end of file
+/**
+ * Instrumentation: i2c_dev_read()/i2c_dev_write() record every transaction. Drivers that own
+ * their device handles (LCD, SSD1306) report theirs with i2c_stats_record() after each transmit.
+ */
+void i2c_stats_record(i2c_port_t port, uint16_t addr, i2c_dir_t dir, uint8_t reg, size_t len, int64_t start_us, esp_err_t res);
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *stats);
+void i2c_stats_reset(void);
+void i2c_stats_dump(void);
+void i2c_trace_dump(void);
+
+#define I2C_DEV_TAKE(dev) do { esp_err_t _res = i2c_bus_lock((dev)->port); if (_res != ESP_OK) return _res; } while (0)
+#define I2C_DEV_GIVE(dev) i2c_bus_unlock((dev)->port)
+
+#endif /* I2C_H_ */
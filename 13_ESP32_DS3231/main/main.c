@@ -17,12 +17,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
-#include "driver/i2c.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "ds3231.h"
+#include "ds3231_sqw.h"
+#include "rtc_sync.h"
+#include "ds3231_alarm.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
 #include "sdkconfig.h"
 
 // Etiqueta para mensajes de log
@@ -33,9 +36,54 @@
 #define I2C_MASTER_SCL_IO           22      // Pin GPIO para SCL
 #define I2C_MASTER_NUM             I2C_NUM_0 // Puerto I2C a utilizar
 
+// Origen de la hora que muestra el bucle principal
+#define TIME_SOURCE_I2C             0       // Leer el DS3231 por I2C cada segundo
+#define TIME_SOURCE_SQW             1       // Hora en RAM avanzada por la onda cuadrada de 1 Hz
+#define TIME_SOURCE_SYSTEM          2       // Reloj del sistema sincronizado con el DS3231
+#define RTC_TIME_SOURCE             TIME_SOURCE_SYSTEM
+
+// Hora mantenida en RAM con la onda cuadrada de 1 Hz (pin INT/SQW del DS3231)
+#define SQW_INT_PIN                 GPIO_NUM_4 // Pin GPIO conectado a INT/SQW
+#define SQW_RESYNC_INTERVAL_S       600     // Segundos entre relecturas por I2C
+#define TEMP_READ_INTERVAL_S        64      // El DS3231 convierte la temperatura cada 64 s
+
+// Sincronización del reloj del sistema
+#define RTC_SYNC_INTERVAL_S         3600    // Segundos entre medidas de deriva
+
+// Temporizadores de la aplicación sobre las alarmas del DS3231 (usa el pin INT/SQW,
+// así que no puede combinarse con TIME_SOURCE_SQW)
+#define USE_ALARM_SCHEDULER         1
+#define ALARM_INT_PIN               SQW_INT_PIN
+#define ALARM_DEMO_PERIOD_S         15      // Periodo del temporizador de ejemplo
+
+// Medida de transacciones I2C por segundo al arrancar (0 = desactivada)
+#define I2C_BENCHMARK               0
+#define I2C_BENCHMARK_TRANSACTIONS  1000    // Lecturas de los registros de hora por medida
+
+// Estadísticas de las transacciones I2C (ver I2C_DEV_STATS en i2c.h)
+#define I2C_STATS_DUMP_INTERVAL_S   300     // Segundos entre volcados de las estadísticas
+
 // Variables globales
 static float temperature;                    // Variable para almacenar la temperatura
 static struct tm rtc_time;                   // Estructura para almacenar la hora
+static ds3231_shadow_t rtc_shadow;           // Copia de los registros de configuración
+static ds3231_sqw_clock_t sqw_clock;         // Hora en RAM avanzada por la onda cuadrada
+static rtc_sync_t rtc_sync;                  // Sincronización del reloj del sistema
+
+#if USE_ALARM_SCHEDULER && RTC_TIME_SOURCE != TIME_SOURCE_SQW
+static ds3231_sched_t alarm_sched;           // Temporizadores sobre las alarmas del DS3231
+
+/**
+ * @brief Temporizador de ejemplo, lo ejecuta la tarea del planificador al llegar la alarma
+ * 
+ * @param arg Texto que identifica al temporizador
+ */
+static void alarm_demo_cb(void *arg)
+{
+    ESP_LOGI(TAG, "Alarma: %s (%lu interrupciones, %lu temporizadores ejecutados)", (const char *)arg,
+            (unsigned long)alarm_sched.interrupts, (unsigned long)alarm_sched.dispatched);
+}
+#endif
 
 /**
  * @brief Inicializa el DS3231
@@ -56,7 +104,7 @@ static esp_err_t ds3231_init(i2c_dev_t *dev)
     }
     
     // Verificar si el DS3231 está presente
-    uint8_t data;
+    int8_t data;
     ret = ds3231_get_aging_offset(dev, &data);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "No se pudo comunicar con el DS3231: %s", 
@@ -64,60 +112,97 @@ static esp_err_t ds3231_init(i2c_dev_t *dev)
         return ret;
     }
     
+    // Cargar la copia de los registros de configuración y asegurar que el oscilador
+    // siga funcionando con la batería (EOSC = 0); si ya lo está no se escribe nada
+    ret = ds3231_shadow_load(dev, &rtc_shadow);
+    if (ret == ESP_OK) {
+        ret = ds3231_shadow_update_bits(dev, &rtc_shadow, DS3231_ADDR_CONTROL, DS3231_CTRL_OSCILLATOR, 0);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo configurar el DS3231: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
     ESP_LOGI(TAG, "DS3231 inicializado correctamente");
     return ESP_OK;
 }
 
 /**
- * @brief Obtiene la hora actual del DS3231
+ * @brief Lee la hora y la temperatura del DS3231 en una sola transacción I2C
+ * 
+ * Los registros 0x00-0x12 son contiguos: una lectura en ráfaga trae hora, alarmas,
+ * control, estado, envejecimiento y temperatura, y todo se decodifica de la copia.
  * 
  * @param dev Puntero a la estructura del dispositivo DS3231
  * @param timeinfo Puntero a la estructura para almacenar la hora
+ * @param temp Puntero a la variable para almacenar la temperatura
  * @return esp_err_t Código de error ESP_OK si es exitoso
  */
-static esp_err_t get_current_time(i2c_dev_t *dev, struct tm *timeinfo)
+static esp_err_t read_time_and_temperature(i2c_dev_t *dev, struct tm *timeinfo, float *temp)
 {
-    if (dev == NULL || timeinfo == NULL) {
+    if (dev == NULL || timeinfo == NULL || temp == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    esp_err_t ret = ds3231_get_time(dev, timeinfo);
+    ds3231_snapshot_t snap;
+    esp_err_t ret = ds3231_read_snapshot(dev, &snap);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error al obtener la hora: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Error al leer los registros: %s", esp_err_to_name(ret));
         return ret;
     }
     
+    ds3231_snapshot_get_time(&snap, timeinfo);
+    ds3231_snapshot_get_temp_float(&snap, temp);
+    
+    // La lectura completa también refresca la copia de los registros de configuración
+    ds3231_shadow_load_snapshot(&rtc_shadow, &snap);
+    
+    // El bit OSF indica que el oscilador se detuvo y la hora no es fiable
+    uint8_t status;
+    ds3231_snapshot_get_status(&snap, &status);
+    if (status & DS3231_STAT_OSCILLATOR) {
+        ESP_LOGW(TAG, "El oscilador se detuvo: la hora debe ajustarse");
+    }
+    
     return ESP_OK;
 }
 
+#if I2C_BENCHMARK
 /**
- * @brief Obtiene la temperatura del DS3231
+ * @brief Mide cuántas transacciones I2C por segundo admite el controlador
+ * 
+ * Cada transacción es una lectura de los 7 registros de hora (escritura de la dirección,
+ * START repetido y lectura), la operación más frecuente del ejemplo. Con el manejador del
+ * dispositivo persistente no se reserva memoria en cada transacción.
  * 
  * @param dev Puntero a la estructura del dispositivo DS3231
- * @param temp Puntero a la variable para almacenar la temperatura
- * @return esp_err_t Código de error ESP_OK si es exitoso
  */
-static esp_err_t get_temperature(i2c_dev_t *dev, float *temp)
+static void i2c_benchmark(i2c_dev_t *dev)
 {
-    if (dev == NULL || temp == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    uint8_t data[7];
+    uint32_t errors = 0;
     
-    esp_err_t ret = ds3231_get_temp_float(dev, temp);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error al obtener la temperatura: %s", esp_err_to_name(ret));
-        return ret;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < I2C_BENCHMARK_TRANSACTIONS; i++) {
+        if (i2c_dev_read_reg(dev, DS3231_ADDR_TIME, data, sizeof(data)) != ESP_OK) {
+            errors++;
+        }
     }
+    int64_t elapsed = esp_timer_get_time() - start;
     
-    return ESP_OK;
+    ESP_LOGI(TAG, "I2C: %d transacciones en %lld us, %.0f transacciones/s, %.1f us/transacción, %lu errores",
+            I2C_BENCHMARK_TRANSACTIONS, elapsed, I2C_BENCHMARK_TRANSACTIONS * 1e6 / elapsed,
+            (double)elapsed / I2C_BENCHMARK_TRANSACTIONS, (unsigned long)errors);
 }
+#endif
 
 /**
  * @brief Función principal de la aplicación
  */
 void app_main(void)
 {
-    i2c_dev_t dev = {0};  // Estructura del dispositivo DS3231
+    static i2c_dev_t dev = {0};  // Estructura del dispositivo DS3231 (la usa también la tarea SQW)
+    int source = TIME_SOURCE_I2C;
     
     // Inicializar el DS3231
     esp_err_t ret = ds3231_init(&dev);
@@ -126,21 +211,74 @@ void app_main(void)
         vTaskDelay(1000 / portTICK_PERIOD_MS);
         esp_restart();
     }
+
+#if I2C_BENCHMARK
+    i2c_benchmark(&dev);
+#endif
+    
+#if RTC_TIME_SOURCE == TIME_SOURCE_SQW
+    // Leer la hora una vez y avanzarla en cada flanco de la onda cuadrada
+    ret = ds3231_sqw_clock_start(&sqw_clock, &dev, &rtc_shadow, SQW_INT_PIN, SQW_RESYNC_INTERVAL_S);
+    if (ret == ESP_OK) {
+        source = TIME_SOURCE_SQW;
+    } else {
+        ESP_LOGW(TAG, "Sin onda cuadrada en GPIO%d (%s), se leerá el DS3231 cada segundo",
+                SQW_INT_PIN, esp_err_to_name(ret));
+    }
+#elif RTC_TIME_SOURCE == TIME_SOURCE_SYSTEM
+    // Ajustar el reloj del sistema con el DS3231; después time() no usa el bus I2C
+    ret = rtc_sync_start(&rtc_sync, &dev, RTC_SYNC_INTERVAL_S);
+    if (ret == ESP_OK) {
+        source = TIME_SOURCE_SYSTEM;
+    } else {
+        ESP_LOGW(TAG, "No se pudo sincronizar el reloj del sistema (%s), se leerá el DS3231 cada segundo",
+                esp_err_to_name(ret));
+    }
+#endif
+
+#if USE_ALARM_SCHEDULER && RTC_TIME_SOURCE != TIME_SOURCE_SQW
+    // Trabajo periódico sin tareas de sondeo: el DS3231 despierta al planificador por INT
+    ret = ds3231_sched_start(&alarm_sched, &dev, &rtc_shadow, ALARM_INT_PIN);
+    if (ret == ESP_OK) {
+        ret = ds3231_sched_add_after(&alarm_sched, ALARM_DEMO_PERIOD_S, ALARM_DEMO_PERIOD_S,
+                alarm_demo_cb, "cada 15 s", NULL);
+    }
+    if (ret == ESP_OK) {
+        // Al comienzo del próximo minuto y luego cada minuto (lo puede llevar la alarma 2)
+        struct tm start;
+        ret = ds3231_get_time(&dev, &start);
+        if (ret == ESP_OK) {
+            time_t now = ds3231_tm_to_epoch(&start);
+            ret = ds3231_sched_add_at(&alarm_sched, now - now % 60 + 60, 60,
+                    alarm_demo_cb, "cada minuto", NULL);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No se pudo iniciar el planificador de alarmas en GPIO%d (%s)",
+                ALARM_INT_PIN, esp_err_to_name(ret));
+    }
+#endif
     
     ESP_LOGI(TAG, "Ejemplo de uso del DS3231 iniciado");
     
     // Bucle principal
-    while (1) {
-        // Obtener la hora actual
-        if (get_current_time(&dev, &rtc_time) != ESP_OK) {
-            ESP_LOGW(TAG, "No se pudo obtener la hora, reintentando...");
-            vTaskDelay(1000 / portTICK_PERIOD_MS);
-            continue;
-        }
-        
-        // Obtener la temperatura
-        if (get_temperature(&dev, &temperature) != ESP_OK) {
-            ESP_LOGW(TAG, "No se pudo obtener la temperatura, reintentando...");
+    for (uint32_t n = 0; ; n++) {
+        if (source != TIME_SOURCE_I2C) {
+            // La hora es una lectura de memoria; la temperatura solo cambia cada 64 s
+            if (source == TIME_SOURCE_SQW) {
+                ds3231_sqw_clock_get_time(&sqw_clock, &rtc_time);
+            } else {
+                time_t now = time(NULL);
+                gmtime_r(&now, &rtc_time);
+            }
+            if (n % TEMP_READ_INTERVAL_S == 0) {
+                ds3231_get_temp_float(&dev, &temperature);
+            }
+        } else if (read_time_and_temperature(&dev, &rtc_time, &temperature) != ESP_OK) {
+            // Obtener la hora y la temperatura (una sola transacción)
+            ESP_LOGW(TAG, "No se pudo leer el DS3231, reintentando...");
+            // Las últimas transacciones muestran si el fallo es un NACK, un tiempo agotado...
+            i2c_trace_dump();
             vTaskDelay(1000 / portTICK_PERIOD_MS);
             continue;
         }
@@ -155,10 +293,14 @@ void app_main(void)
                 rtc_time.tm_sec,          // Segundos (0-59)
                 temperature);
         
+        if (n % I2C_STATS_DUMP_INTERVAL_S == I2C_STATS_DUMP_INTERVAL_S - 1) {
+            i2c_stats_dump();
+        }
+        
         // Esperar 1 segundo antes de la siguiente lectura
         vTaskDelay(1000 / portTICK_PERIOD_MS);
     }
     
     // Nota: En una aplicación real, deberías limpiar los recursos al salir
-    // i2c_driver_delete(I2C_MASTER_NUM);
-}
\ No newline at end of file
+    // i2c_dev_delete(&dev);
+}
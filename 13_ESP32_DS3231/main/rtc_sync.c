@@ -0,0 +1,161 @@
+#include <string.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "rtc_sync.h"
+
+#define TAG "RTC_SYNC"
+
+#define CHECK_ARG(ARG) do { if (!ARG) return ESP_ERR_INVALID_ARG; } while (0)
+
+/* the fine poll starts this long before the expected rollover */
+#define FINE_WINDOW_US 30000
+#define ROLLOVER_TIMEOUT_US 2100000
+
+static esp_err_t read_seconds(i2c_dev_t *dev, uint8_t *sec)
+{
+	return i2c_dev_read_reg(dev, DS3231_ADDR_TIME, sec, 1);
+}
+
+/*
+ * Finds the instant the RTC seconds register changes.
+ * A coarse poll (one read per tick) locates the rollover within a tick, then the next one
+ * is caught with back-to-back reads of the time registers started just before it.
+ */
+static esp_err_t wait_rollover(i2c_dev_t *dev, time_t *rtc, int64_t *at_us)
+{
+	uint8_t first, sec;
+	int64_t start = esp_timer_get_time();
+
+	esp_err_t res = read_seconds(dev, &first);
+	if (res != ESP_OK) return res;
+
+	do
+	{
+		if (esp_timer_get_time() - start > ROLLOVER_TIMEOUT_US) return ESP_ERR_TIMEOUT;
+		vTaskDelay(1);
+		res = read_seconds(dev, &sec);
+		if (res != ESP_OK) return res;
+	} while (sec == first);
+	int64_t coarse = esp_timer_get_time();
+
+	int64_t wait_us = coarse + 1000000 - FINE_WINDOW_US - esp_timer_get_time();
+	if (wait_us > 0) vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+
+	struct tm time;
+	int64_t prev = esp_timer_get_time();
+	res = ds3231_get_time(dev, &time);
+	if (res != ESP_OK) return res;
+	int old_sec = time.tm_sec;
+
+	while (1)
+	{
+		int64_t read_start = esp_timer_get_time();
+		if (read_start - coarse > ROLLOVER_TIMEOUT_US) return ESP_ERR_TIMEOUT;
+
+		res = ds3231_get_time(dev, &time);
+		if (res != ESP_OK) return res;
+		if (time.tm_sec != old_sec) break;
+		prev = read_start;
+	}
+
+	/* the rollover happened between the start of the previous read and the end of this one */
+	*at_us = (prev + esp_timer_get_time()) / 2;
+	*rtc = ds3231_tm_to_epoch(&time);
+
+	return ESP_OK;
+}
+
+esp_err_t rtc_sync_now(rtc_sync_t *sync)
+{
+	CHECK_ARG(sync);
+
+	time_t rtc;
+	int64_t at_us;
+	esp_err_t res = wait_rollover(sync->dev, &rtc, &at_us);
+	if (res != ESP_OK) return res;
+
+	/* system time at the rollover instant */
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	int64_t elapsed = esp_timer_get_time() - at_us;
+	int64_t system_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec - elapsed;
+	int64_t offset = system_us - (int64_t)rtc * 1000000;
+
+	if (sync->syncs > 0)
+	{
+		int64_t span = at_us - sync->last_sync_us;
+		if (span > 0) sync->drift_ppm = (float)offset * 1e6f / span;
+	}
+
+	if (sync->syncs == 0 || offset > RTC_SYNC_MAX_SLEW_US || offset < -RTC_SYNC_MAX_SLEW_US)
+	{
+		int64_t target = (int64_t)rtc * 1000000 + (esp_timer_get_time() - at_us);
+		struct timeval tv = { .tv_sec = target / 1000000, .tv_usec = target % 1000000 };
+		settimeofday(&tv, NULL);
+		sync->steps++;
+	}
+	else
+	{
+		struct timeval delta = { .tv_sec = -offset / 1000000, .tv_usec = -offset % 1000000 };
+		adjtime(&delta, NULL);
+		sync->slews++;
+	}
+
+	sync->last_offset_us = offset;
+	sync->last_sync_us = at_us;
+	sync->syncs++;
+
+	ESP_LOGI(TAG, "Sync %lu: offset %lld us, drift %.2f ppm", (unsigned long)sync->syncs,
+			(long long)offset, sync->drift_ppm);
+	return ESP_OK;
+}
+
+static void rtc_sync_task(void *arg)
+{
+	rtc_sync_t *sync = (rtc_sync_t *)arg;
+
+	while (1)
+	{
+		vTaskDelay(pdMS_TO_TICKS(sync->interval * 1000));
+		esp_err_t res = rtc_sync_now(sync);
+		if (res != ESP_OK)
+			ESP_LOGW(TAG, "Sync failed: %s", esp_err_to_name(res));
+	}
+}
+
+esp_err_t rtc_sync_start(rtc_sync_t *sync, i2c_dev_t *dev, uint32_t interval)
+{
+	CHECK_ARG(sync);
+	CHECK_ARG(dev);
+	CHECK_ARG(interval);
+
+	memset(sync, 0, sizeof(*sync));
+	sync->dev = dev;
+	sync->interval = interval;
+
+	/* the first sync runs in the caller, so time() is valid when this returns */
+	esp_err_t res = rtc_sync_now(sync);
+	if (res != ESP_OK) return res;
+
+	if (xTaskCreate(rtc_sync_task, "rtc_sync", RTC_SYNC_TASK_STACK, sync, RTC_SYNC_TASK_PRIORITY, &sync->task) != pdPASS)
+		return ESP_ERR_NO_MEM;
+
+	return ESP_OK;
+}
+
+esp_err_t rtc_sync_stop(rtc_sync_t *sync)
+{
+	CHECK_ARG(sync);
+
+	if (sync->task)
+	{
+		vTaskDelete(sync->task);
+		sync->task = NULL;
+	}
+	return ESP_OK;
+}
@@ -0,0 +1,41 @@
+#ifndef MAIN_RTC_SYNC_H_
+#define MAIN_RTC_SYNC_H_
+
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ds3231.h"
+
+#define RTC_SYNC_TASK_STACK    3072
+#define RTC_SYNC_TASK_PRIORITY 4
+
+/* offsets below this are slewed with adjtime(), larger ones step the clock */
+#define RTC_SYNC_MAX_SLEW_US   500000
+
+/**
+ * Keeps the system clock (gettimeofday()/time()) locked to the DS3231.
+ *
+ * Each sync waits for the seconds rollover of the RTC to get sub-millisecond alignment,
+ * measures the offset of the system clock at that instant and corrects it. The first sync
+ * steps the clock with settimeofday(); later ones slew it with adjtime() and estimate the
+ * drift of the ESP32 clock against the RTC.
+ */
+typedef struct {
+	i2c_dev_t *dev;
+	uint32_t interval;          // seconds between drift checks
+	TaskHandle_t task;
+
+	int64_t last_offset_us;     // system minus RTC at the last sync, before correcting
+	int64_t last_sync_us;       // esp_timer time of the last sync
+	float drift_ppm;            // positive when the ESP32 clock runs fast
+	uint32_t syncs;
+	uint32_t steps;
+	uint32_t slews;
+} rtc_sync_t;
+
+esp_err_t rtc_sync_start(rtc_sync_t *sync, i2c_dev_t *dev, uint32_t interval);
+esp_err_t rtc_sync_now(rtc_sync_t *sync);
+esp_err_t rtc_sync_stop(rtc_sync_t *sync);
+
+#endif /* MAIN_RTC_SYNC_H_ */
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <string.h>
+#include "hd44780_emu.h"
+
+// Time taken by one byte plus its ACK bit on the bus
+static uint64_t byte_time_ns(const hd44780_emu_t *emu)
+{
+    return 9ULL * 1000000000ULL / emu->bus_hz;
+}
+
+static uint64_t exec_time_ns(const hd44780_emu_t *emu, uint64_t ns)
+{
+    return ns * HD44780_FOSC_HZ / emu->fosc_hz;
+}
+
+static void check_ready(hd44780_emu_t *emu, uint8_t value, bool rs)
+{
+    if (emu->now_ns >= emu->busy_until_ns) return;
+
+    if (emu->stats.violations < HD44780_EMU_MAX_VIOLATIONS)
+    {
+        hd44780_emu_violation_t *v = &emu->violation_log[emu->stats.violations];
+        v->at_ns = emu->now_ns;
+        v->early_ns = emu->busy_until_ns - emu->now_ns;
+        v->value = value;
+        v->rs = rs;
+    }
+    emu->stats.violations++;
+}
+
+// Maps a DDRAM address to a cell of the emulated memory
+static uint8_t *ddram_cell(hd44780_emu_t *emu, uint8_t addr)
+{
+    if (emu->two_lines)
+        return &emu->ddram[addr >= 0x40 ? 1 : 0][(addr & 0x3f) % HD44780_EMU_LINE_LEN];
+
+    addr %= 2 * HD44780_EMU_LINE_LEN;
+    return &emu->ddram[addr / HD44780_EMU_LINE_LEN][addr % HD44780_EMU_LINE_LEN];
+}
+
+static void move_ac(hd44780_emu_t *emu, bool increment)
+{
+    if (emu->ac_cgram)
+    {
+        emu->ac = (emu->ac + (increment ? 1 : -1)) & 0x3f;
+        return;
+    }
+
+    if (!emu->two_lines)
+    {
+        emu->ac = (emu->ac + (increment ? 1 : 2 * HD44780_EMU_LINE_LEN - 1)) % (2 * HD44780_EMU_LINE_LEN);
+        return;
+    }
+
+    // Two-line mode: 0x00-0x27 and 0x40-0x67, wrapping from one line to the other
+    if (increment)
+    {
+        if (emu->ac == 0x27) emu->ac = 0x40;
+        else if (emu->ac >= 0x67) emu->ac = 0x00;
+        else emu->ac++;
+    }
+    else
+    {
+        if (emu->ac == 0x00) emu->ac = 0x67;
+        else if (emu->ac == 0x40) emu->ac = 0x27;
+        else emu->ac--;
+    }
+}
+
+static void shift_display(hd44780_emu_t *emu, bool left)
+{
+    emu->shift = (emu->shift + (left ? 1 : HD44780_EMU_LINE_LEN - 1)) % HD44780_EMU_LINE_LEN;
+}
+
+static void execute_instruction(hd44780_emu_t *emu, uint8_t cmd)
+{
+    uint64_t exec_ns = HD44780_T_CMD_NS;
+
+    emu->stats.instructions++;
+
+    if (cmd & 0x80) // Set DDRAM address
+    {
+        emu->ac = cmd & 0x7f;
+        emu->ac_cgram = false;
+    }
+    else if (cmd & 0x40) // Set CGRAM address
+    {
+        emu->ac = cmd & 0x3f;
+        emu->ac_cgram = true;
+    }
+    else if (cmd & 0x20) // Function set
+    {
+        bool eight_bit = cmd & 0x10;
+        if (eight_bit && !emu->four_bit && emu->init_step < 2)
+            exec_ns = emu->init_step++ == 0 ? HD44780_T_INIT_1_NS : HD44780_T_INIT_2_NS;
+        emu->four_bit = !eight_bit;
+        emu->two_lines = cmd & 0x08;
+        emu->font_5x10 = cmd & 0x04;
+    }
+    else if (cmd & 0x10) // Cursor or display shift
+    {
+        bool right = cmd & 0x04;
+        if (cmd & 0x08) shift_display(emu, !right);
+        else move_ac(emu, right);
+    }
+    else if (cmd & 0x08) // Display on/off control
+    {
+        emu->display_on = cmd & 0x04;
+        emu->cursor_on = cmd & 0x02;
+        emu->blink_on = cmd & 0x01;
+    }
+    else if (cmd & 0x04) // Entry mode set
+    {
+        emu->increment = cmd & 0x02;
+        emu->entry_shift = cmd & 0x01;
+    }
+    else if (cmd & 0x02) // Return home
+    {
+        emu->ac = 0;
+        emu->ac_cgram = false;
+        emu->shift = 0;
+        exec_ns = HD44780_T_CLEAR_HOME_NS;
+    }
+    else if (cmd & 0x01) // Clear display
+    {
+        memset(emu->ddram, ' ', sizeof(emu->ddram));
+        emu->ac = 0;
+        emu->ac_cgram = false;
+        emu->shift = 0;
+        emu->increment = true;
+        exec_ns = HD44780_T_CLEAR_HOME_NS;
+    }
+
+    emu->busy_until_ns = emu->now_ns + exec_time_ns(emu, exec_ns);
+}
+
+static void execute_data(hd44780_emu_t *emu, uint8_t data)
+{
+    emu->stats.data_writes++;
+
+    if (emu->ac_cgram)
+    {
+        emu->cgram[emu->ac] = data & 0x1f;
+    }
+    else
+    {
+        *ddram_cell(emu, emu->ac) = data;
+        if (emu->entry_shift) shift_display(emu, emu->increment);
+    }
+    move_ac(emu, emu->increment);
+
+    emu->busy_until_ns = emu->now_ns + exec_time_ns(emu, HD44780_T_DATA_NS);
+}
+
+// Called on every EN falling edge with the value present on the expander outputs
+static void latch_nibble(hd44780_emu_t *emu, uint8_t port)
+{
+    uint8_t nibble = port >> 4;
+    bool rs = port & PCF8574_RS;
+
+    if (port & PCF8574_RW) // Read cycle, nothing is written
+    {
+        if (emu->four_bit) emu->read_low = !emu->read_low;
+        return;
+    }
+
+    if (!emu->four_bit)
+    {
+        // DB0-DB3 are not wired on the backpack and read as 1 through the internal pull-ups
+        uint8_t value = (nibble << 4) | 0x0f;
+        check_ready(emu, value, rs);
+        if (rs) execute_data(emu, value);
+        else execute_instruction(emu, value);
+        return;
+    }
+
+    if (!emu->nibble_pending)
+    {
+        check_ready(emu, nibble << 4, rs);
+        emu->nibble_high = nibble;
+        emu->nibble_pending = true;
+        return;
+    }
+
+    emu->nibble_pending = false;
+    uint8_t value = (emu->nibble_high << 4) | nibble;
+    if (rs) execute_data(emu, value);
+    else execute_instruction(emu, value);
+}
+
+void hd44780_emu_reset(hd44780_emu_t *emu, uint8_t address, uint32_t bus_hz)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->address = address;
+    emu->bus_hz = bus_hz;
+    emu->port = 0xff; // PCF8574 outputs are high after power on
+    emu->rw_wired = true;
+    emu->fosc_hz = HD44780_FOSC_HZ;
+    memset(emu->ddram, ' ', sizeof(emu->ddram));
+    emu->increment = true;
+    emu->busy_until_ns = HD44780_T_POWER_ON_NS;
+}
+
+void hd44780_emu_write(hd44780_emu_t *emu, const uint8_t *data, size_t len)
+{
+    uint64_t byte_ns = byte_time_ns(emu);
+
+    emu->stats.transactions++;
+    emu->stats.bus_bytes += len + 1;
+
+    // START condition and address byte
+    emu->now_ns += byte_ns + byte_ns / 9;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        // The expander updates its outputs on the ACK of each data byte
+        emu->now_ns += byte_ns;
+        uint8_t prev = emu->port;
+        emu->port = data[i];
+        if ((prev & PCF8574_EN) && !(data[i] & PCF8574_EN))
+            latch_nibble(emu, emu->rw_wired ? data[i] : data[i] & ~PCF8574_RW);
+    }
+
+    // STOP condition
+    emu->now_ns += byte_ns / 9;
+    emu->stats.elapsed_ns = emu->now_ns;
+}
+
+uint8_t hd44780_emu_read(hd44780_emu_t *emu)
+{
+    uint64_t byte_ns = byte_time_ns(emu);
+    uint8_t value = emu->port;
+
+    emu->stats.transactions++;
+    emu->stats.bus_bytes += 2;
+
+    // START condition and address byte; the expander samples its pins on the ACK
+    emu->now_ns += byte_ns + byte_ns / 9;
+
+    if (emu->rw_wired && (emu->port & PCF8574_RW) && (emu->port & PCF8574_EN))
+    {
+        uint8_t nibble;
+        if (!emu->four_bit || !emu->read_low)
+            nibble = (emu->now_ns < emu->busy_until_ns ? 0x08 : 0x00) | ((emu->ac >> 4) & 0x07);
+        else
+            nibble = emu->ac & 0x0f;
+        value = (nibble << 4) | (emu->port & 0x0f);
+    }
+
+    // Data byte, NACK and STOP condition
+    emu->now_ns += byte_ns + byte_ns / 9;
+    emu->stats.elapsed_ns = emu->now_ns;
+    return value;
+}
+
+void hd44780_emu_advance(hd44780_emu_t *emu, uint64_t ns)
+{
+    emu->now_ns += ns;
+    emu->stats.elapsed_ns = emu->now_ns;
+}
+
+void hd44780_emu_get_line(const hd44780_emu_t *emu, int row, int cols, char *out)
+{
+    for (int c = 0; c < cols; c++)
+    {
+        uint8_t ch = emu->ddram[row & 1][(c + emu->shift) % HD44780_EMU_LINE_LEN];
+        out[c] = (ch >= 0x20 && ch < 0x7f) ? ch : '?';
+    }
+    out[cols] = '\0';
+}
+
+void hd44780_emu_print_report(const hd44780_emu_t *emu, int cols)
+{
+    char line[HD44780_EMU_LINE_LEN + 1];
+
+    printf("+");
+    for (int c = 0; c < cols; c++) printf("-");
+    printf("+\n");
+    for (int row = 0; row < 2; row++)
+    {
+        hd44780_emu_get_line(emu, row, cols, line);
+        printf("|%s|\n", line);
+    }
+    printf("+");
+    for (int c = 0; c < cols; c++) printf("-");
+    printf("+\n");
+
+    printf("display %s, cursor %s, blink %s, %s mode, %s, %s font, backlight %s\n",
+           emu->display_on ? "on" : "off", emu->cursor_on ? "on" : "off", emu->blink_on ? "on" : "off",
+           emu->four_bit ? "4-bit" : "8-bit", emu->two_lines ? "2 lines" : "1 line",
+           emu->font_5x10 ? "5x10" : "5x8", (emu->port & PCF8574_BL) ? "on" : "off");
+    printf("I2C 0x%02X @ %lu Hz: %lu transactions, %lu bytes on the bus\n", emu->address,
+           (unsigned long)emu->bus_hz, (unsigned long)emu->stats.transactions, (unsigned long)emu->stats.bus_bytes);
+    printf("instructions: %lu, data writes: %lu\n",
+           (unsigned long)emu->stats.instructions, (unsigned long)emu->stats.data_writes);
+    printf("emulated time: %.3f ms\n", emu->stats.elapsed_ns / 1e6);
+    printf("timing violations: %lu\n", (unsigned long)emu->stats.violations);
+
+    for (uint32_t i = 0; i < emu->stats.violations && i < HD44780_EMU_MAX_VIOLATIONS; i++)
+    {
+        const hd44780_emu_violation_t *v = &emu->violation_log[i];
+        printf("  at %.3f ms: %s 0x%02X arrived %.1f us before the controller was ready\n",
+               v->at_ns / 1e6, v->rs ? "data" : "instruction", v->value, v->early_ns / 1e3);
+    }
+}
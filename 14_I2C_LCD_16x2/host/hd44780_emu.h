@@ -0,0 +1,152 @@
+#ifndef HD44780_EMU_H
+#define HD44780_EMU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// PCF8574 pin mapping used by the common I2C LCD backpacks
+#define PCF8574_RS 0x01
+#define PCF8574_RW 0x02
+#define PCF8574_EN 0x04
+#define PCF8574_BL 0x08
+
+// HD44780 geometry
+#define HD44780_EMU_LINE_LEN  40
+#define HD44780_EMU_CGRAM_LEN 64
+
+// HD44780 execution times from the datasheet (fosc = 270 kHz), in nanoseconds.
+// They scale with the oscillator frequency of the emulated controller.
+#define HD44780_FOSC_HZ         270000
+#define HD44780_T_POWER_ON_NS   40000000ULL // Wait after VCC rises before the first instruction
+#define HD44780_T_INIT_1_NS      4100000ULL // After the first 8-bit function set
+#define HD44780_T_INIT_2_NS       100000ULL // After the second 8-bit function set
+#define HD44780_T_CLEAR_HOME_NS  1520000ULL // Clear display / return home
+#define HD44780_T_CMD_NS           37000ULL // Any other instruction
+#define HD44780_T_DATA_NS          41000ULL // Data write (37 us + 4 us address update)
+
+// Number of timing violations kept for the report
+#define HD44780_EMU_MAX_VIOLATIONS 8
+
+/**
+ * Record of an instruction or data write received while the controller was busy
+ * @var at_ns emulated time of the EN falling edge
+ * @var early_ns how long before the controller was ready the write arrived
+ * @var value byte (or nibble during initialization) that was latched
+ * @var rs register select of the write
+*/
+typedef struct
+{
+    uint64_t at_ns;
+    uint64_t early_ns;
+    uint8_t value;
+    bool rs;
+} hd44780_emu_violation_t;
+
+/**
+ * Counters collected while a screen sequence runs
+ * @var transactions number of I2C transactions addressed to the backpack
+ * @var bus_bytes bytes on the wire, including the address byte of each transaction
+ * @var instructions instructions executed (RS = 0)
+ * @var data_writes characters written to DDRAM/CGRAM (RS = 1)
+ * @var violations writes that arrived while the controller was busy
+ * @var elapsed_ns emulated wall-clock time since power on
+*/
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bus_bytes;
+    uint32_t instructions;
+    uint32_t data_writes;
+    uint32_t violations;
+    uint64_t elapsed_ns;
+} hd44780_emu_stats_t;
+
+/**
+ * Emulated PCF8574 backpack + HD44780 controller
+ * @var address I2C address the backpack answers on
+ * @var bus_hz SCL frequency used to compute transfer times
+ * @var port last byte latched on the PCF8574 outputs
+ * @var rw_wired false models backpacks with R/W tied to GND: reads return the latched outputs
+ * @var fosc_hz oscillator frequency of the controller (190-350 kHz on real modules)
+*/
+typedef struct
+{
+    uint8_t address;
+    uint32_t bus_hz;
+    uint8_t port;
+    bool rw_wired;
+    uint32_t fosc_hz;
+
+    // Controller state
+    uint8_t ddram[2][HD44780_EMU_LINE_LEN];
+    uint8_t cgram[HD44780_EMU_CGRAM_LEN];
+    uint8_t ac;              // Address counter (DDRAM address or CGRAM address)
+    bool ac_cgram;           // True when the address counter points to CGRAM
+    bool increment;          // Entry mode I/D
+    bool entry_shift;        // Entry mode S
+    bool display_on;
+    bool cursor_on;
+    bool blink_on;
+    bool four_bit;
+    bool two_lines;
+    bool font_5x10;
+    uint8_t shift;           // Display shift offset (0..39)
+    bool nibble_pending;     // High nibble received, waiting for the low one
+    uint8_t nibble_high;
+    uint8_t init_step;       // Count of 8-bit function sets seen after power on
+    bool read_low;           // Next 4-bit read returns AC3-AC0
+
+    // Timing
+    uint64_t now_ns;
+    uint64_t busy_until_ns;
+
+    hd44780_emu_stats_t stats;
+    hd44780_emu_violation_t violation_log[HD44780_EMU_MAX_VIOLATIONS];
+} hd44780_emu_t;
+
+/**
+ * @brief Puts the emulator in the power-on state of the HD44780 (8-bit mode, display off)
+ * @param emu emulator instance
+ * @param address I2C address of the PCF8574 backpack
+ * @param bus_hz SCL frequency of the bus the backpack is attached to
+*/
+void hd44780_emu_reset(hd44780_emu_t *emu, uint8_t address, uint32_t bus_hz);
+
+/**
+ * @brief Feeds one I2C write transaction to the emulated PCF8574
+ * @note  Every byte updates the expander outputs; each EN falling edge latches a nibble
+ *        into the HD44780. Emulated time advances by the transfer time of the transaction.
+ * @param emu emulator instance
+ * @param data bytes written after the address byte
+ * @param len number of bytes
+*/
+void hd44780_emu_write(hd44780_emu_t *emu, const uint8_t *data, size_t len);
+
+/**
+ * @brief Feeds one single-byte I2C read transaction to the emulated PCF8574
+ * @note  While R/W and EN are high the HD44780 drives D4-D7 with the busy flag and the
+ *        address counter (high nibble first); otherwise the expander returns its outputs.
+ * @return the byte read from the expander pins
+*/
+uint8_t hd44780_emu_read(hd44780_emu_t *emu);
+
+/**
+ * @brief Advances emulated time (used for the delays of the driver)
+*/
+void hd44780_emu_advance(hd44780_emu_t *emu, uint64_t ns);
+
+/**
+ * @brief Copies the visible part of a display line, honouring the display shift
+ * @param row line number (0 or 1)
+ * @param cols number of visible columns (16 for a 16x2 module)
+ * @param out buffer of at least cols + 1 bytes, NUL terminated on return
+*/
+void hd44780_emu_get_line(const hd44780_emu_t *emu, int row, int cols, char *out);
+
+/**
+ * @brief Prints the emulated screen, controller state and the timing report to stdout
+*/
+void hd44780_emu_print_report(const hd44780_emu_t *emu, int cols);
+
+#endif /* HD44780_EMU_H */
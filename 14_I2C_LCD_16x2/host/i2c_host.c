@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "i2c_host.h"
+
+struct i2c_master_bus_t
+{
+    i2c_port_num_t port;
+    hd44780_emu_t *devices[I2C_HOST_MAX_DEVICES];
+    int num_devices;
+};
+
+struct i2c_master_dev_t
+{
+    struct i2c_master_bus_t *bus;
+    hd44780_emu_t *emu;
+    uint32_t scl_speed_hz;
+};
+
+static struct i2c_master_bus_t buses[I2C_NUM_MAX];
+static bool bus_created[I2C_NUM_MAX];
+static uint64_t host_now_ns; // Emulated time shared by every bus
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+static hd44780_emu_t *find_device(struct i2c_master_bus_t *bus, uint16_t address)
+{
+    for (int i = 0; i < bus->num_devices; i++)
+        if (bus->devices[i]->address == address) return bus->devices[i];
+    return NULL;
+}
+
+// Every device on the bus sees the time taken by a transfer to any of them
+static void advance_bus(struct i2c_master_bus_t *bus, const hd44780_emu_t *except, uint64_t ns)
+{
+    host_now_ns += ns;
+    for (int i = 0; i < bus->num_devices; i++)
+        if (bus->devices[i] != except) hd44780_emu_advance(bus->devices[i], ns);
+}
+
+esp_err_t i2c_host_attach(i2c_port_num_t port, hd44780_emu_t *emu)
+{
+    if (port < 0 || port >= I2C_NUM_MAX || !emu) return ESP_ERR_INVALID_ARG;
+    if (buses[port].num_devices == I2C_HOST_MAX_DEVICES) return ESP_ERR_NO_MEM;
+
+    buses[port].devices[buses[port].num_devices++] = emu;
+    return ESP_OK;
+}
+
+void i2c_host_usleep(unsigned int us)
+{
+    host_now_ns += us * 1000ULL;
+    for (int p = 0; p < I2C_NUM_MAX; p++)
+        for (int i = 0; i < buses[p].num_devices; i++)
+            hd44780_emu_advance(buses[p].devices[i], us * 1000ULL);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return host_now_ns / 1000;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    if (!bus_config || !ret_bus_handle || bus_config->i2c_port < 0 || bus_config->i2c_port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (bus_created[bus_config->i2c_port]) return ESP_ERR_INVALID_STATE;
+
+    bus_created[bus_config->i2c_port] = true;
+    buses[bus_config->i2c_port].port = bus_config->i2c_port;
+    *ret_bus_handle = &buses[bus_config->i2c_port];
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle)
+{
+    if (!bus_handle) return ESP_ERR_INVALID_ARG;
+
+    bus_created[bus_handle->port] = false;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config, i2c_master_dev_handle_t *ret_handle)
+{
+    if (!bus_handle || !dev_config || !ret_handle) return ESP_ERR_INVALID_ARG;
+
+    struct i2c_master_dev_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) return ESP_ERR_NO_MEM;
+
+    dev->bus = bus_handle;
+    dev->emu = find_device(bus_handle, dev_config->device_address);
+    dev->scl_speed_hz = dev_config->scl_speed_hz;
+    if (dev->emu) dev->emu->bus_hz = dev_config->scl_speed_hz;
+    *ret_handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    if (!handle) return ESP_ERR_INVALID_ARG;
+
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !write_buffer) return ESP_ERR_INVALID_ARG;
+
+    // Nobody ACKs the address: the transfer stops after the first byte
+    if (!i2c_dev->emu)
+    {
+        advance_bus(i2c_dev->bus, NULL, 9ULL * 1000000000ULL / i2c_dev->scl_speed_hz);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint64_t before = i2c_dev->emu->now_ns;
+    hd44780_emu_write(i2c_dev->emu, write_buffer, write_size);
+    advance_bus(i2c_dev->bus, i2c_dev->emu, i2c_dev->emu->now_ns - before);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !read_buffer || read_size == 0) return ESP_ERR_INVALID_ARG;
+    if (!i2c_dev->emu) return ESP_ERR_INVALID_STATE;
+
+    for (size_t i = 0; i < read_size; i++)
+    {
+        uint64_t before = i2c_dev->emu->now_ns;
+        read_buffer[i] = hd44780_emu_read(i2c_dev->emu);
+        advance_bus(i2c_dev->bus, i2c_dev->emu, i2c_dev->emu->now_ns - before);
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!bus_handle) return ESP_ERR_INVALID_ARG;
+
+    return find_device(bus_handle, address) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,18 @@
+#ifndef I2C_HOST_H
+#define I2C_HOST_H
+
+#include "driver/i2c_master.h"
+#include "hd44780_emu.h"
+
+// Maximum number of emulated displays per bus
+#define I2C_HOST_MAX_DEVICES 8
+
+/**
+ * @brief Attaches an emulated LCD backpack to a host I2C port
+ * @note  All devices on a port share the same emulated clock: a transfer to one display
+ *        (or a driver delay) advances the time seen by every display on the bus.
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the port is full
+*/
+esp_err_t i2c_host_attach(i2c_port_num_t port, hd44780_emu_t *emu);
+
+#endif /* I2C_HOST_H */
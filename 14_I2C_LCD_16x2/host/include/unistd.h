@@ -0,0 +1,10 @@
+#ifndef HOST_UNISTD_H
+#define HOST_UNISTD_H
+
+#include_next <unistd.h>
+
+// Delays of the driver advance the emulated clock instead of sleeping
+void i2c_host_usleep(unsigned int us);
+#define usleep(us) i2c_host_usleep(us)
+
+#endif /* HOST_UNISTD_H */
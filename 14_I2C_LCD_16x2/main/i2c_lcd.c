@@ -1,123 +1,284 @@
+#include <string.h>
 #include "i2c_lcd.h"
 #include "esp_log.h"
-#include "driver/i2c.h"
+#include "esp_timer.h"
 #include "unistd.h"
 
-esp_err_t err; // Variable to store I2C communication errors
 static const char *TAG = "LCD"; // Tag for logging
 
+// PCF8574 pins wired to the LCD control lines
+#define LCD_PIN_RS 0x01 // Register Select
+#define LCD_PIN_RW 0x02 // Read/Write
+#define LCD_PIN_EN 0x04 // Enable
+#define LCD_PIN_BL 0x08 // Backlight
 
-// I2C master initialization
-static esp_err_t i2c_master_init(void)
+// DDRAM address of the first column of each row (20x4 modules continue rows 0/1 at 0x14/0x54)
+static const uint8_t lcd_row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+
+// Upper bounds of the latency histogram buckets, in microseconds
+static const uint16_t lcd_latency_bounds_us[LCD_LATENCY_BUCKETS - 1] = {100, 200, 500, 1000, 1500, 2000, 5000};
+
+static esp_err_t lcd_write(lcd_handle_t *lcd, const uint8_t *data, size_t len)
+{
+    return i2c_master_transmit(lcd->i2c_master_dev, data, len, I2C_MASTER_TIMEOUT_MS);
+}
+
+// Reads the busy flag. D4-D7 are written high so the PCF8574 can read what the LCD drives on them
+static esp_err_t lcd_read_busy(lcd_handle_t *lcd, bool *busy)
+{
+    uint8_t rd = 0xf0 | lcd->backlight | LCD_PIN_RW;
+    uint8_t strobe[2] = {rd, rd | LCD_PIN_EN};
+    uint8_t finish[3] = {rd, rd | LCD_PIN_EN, rd};
+    uint8_t value = 0xff;
+
+    esp_err_t ret = lcd_write(lcd, strobe, 2); // EN = 1: the LCD drives BF and AC6-AC4
+    if (ret == ESP_OK) ret = i2c_master_receive(lcd->i2c_master_dev, &value, 1, I2C_MASTER_TIMEOUT_MS);
+    // Clock out the second nibble (AC3-AC0) too so the 4-bit interface stays in step
+    if (ret == ESP_OK) ret = lcd_write(lcd, finish, 3);
+
+    lcd->latency.polls++;
+    *busy = value & 0x80;
+    return ret;
+}
+
+static void lcd_record_latency(lcd_handle_t *lcd, uint32_t latency_us)
+{
+    lcd_latency_stats_t *stats = &lcd->latency;
+    int bucket = 0;
+
+    while (bucket < LCD_LATENCY_BUCKETS - 1 && latency_us >= lcd_latency_bounds_us[bucket]) bucket++;
+    stats->histogram[bucket]++;
+    if (stats->count == 0 || latency_us < stats->min_us) stats->min_us = latency_us;
+    if (latency_us > stats->max_us) stats->max_us = latency_us;
+    stats->total_us += latency_us;
+    stats->count++;
+}
+
+// Waits until the controller has finished the last slow command
+static esp_err_t lcd_wait_ready(lcd_handle_t *lcd)
+{
+    esp_err_t ret = ESP_OK;
+    bool busy = true;
+    int64_t ready_at = 0;
+
+    if (lcd->pending_us == 0) return ESP_OK;
+
+    while (lcd->busy_flag && busy)
+    {
+        ret = lcd_read_busy(lcd, &busy);
+        ready_at = esp_timer_get_time();
+        if (ret != ESP_OK || (busy && ready_at - lcd->pending_since > LCD_BUSY_TIMEOUT_US))
+        {
+            ESP_LOGW(TAG, "Busy flag not readable, falling back to fixed delays");
+            lcd->busy_flag = false;
+        }
+    }
+
+    if (lcd->busy_flag)
+    {
+        // Time of the first read that found the controller idle
+        lcd_record_latency(lcd, ready_at - lcd->pending_since);
+    }
+    else
+    {
+        int64_t remaining = lcd->pending_us - (esp_timer_get_time() - lcd->pending_since);
+        if (remaining > 0) usleep(remaining);
+        lcd_record_latency(lcd, lcd->pending_us);
+    }
+    lcd->pending_us = 0;
+    return ret;
+}
+
+// Sends a single nibble (upper 4 bits) while the controller is still in 8-bit mode
+static esp_err_t lcd_send_nibble(lcd_handle_t *lcd, uint8_t nibble)
 {
-    int i2c_master_port = I2C_MASTER_NUM;
-
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER, // Set as I2C master mode
-        .sda_io_num = I2C_MASTER_SDA_IO, // GPIO number for I2C SDA
-        .scl_io_num = I2C_MASTER_SCL_IO, // GPIO number for I2C SCL
-        .sda_pullup_en = GPIO_PULLUP_ENABLE, // Enable pull-up on SDA line
-        .scl_pullup_en = GPIO_PULLUP_ENABLE, // Enable pull-up on SCL line
-        .master.clk_speed = I2C_MASTER_FREQ_HZ, // Set I2C clock frequency
-    };
-
-    // Configure I2C parameters with the given configuration
-    i2c_param_config(i2c_master_port, &conf);
-
-    // Install the I2C driver with the specified parameters
-    return i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0);
+    uint8_t data_t[2];
+
+    data_t[0] = (nibble & 0xf0) | lcd->backlight | LCD_PIN_EN; // Enable (EN) = 1, Register Select (RS) = 0
+    data_t[1] = (nibble & 0xf0) | lcd->backlight;              // Enable (EN) = 0, Register Select (RS) = 0
+
+    return lcd_write(lcd, data_t, 2);
 }
 
-void lcd_send_cmd(char cmd)
+// Sends a full byte as two nibbles, each one latched on the falling edge of EN
+static esp_err_t lcd_send_byte(lcd_handle_t *lcd, uint8_t value, uint8_t rs)
 {
-    char data_u, data_l;
+    uint8_t data_u, data_l;
     uint8_t data_t[4];
-    
-    data_u = (cmd & 0xf0); // Upper nibble of the command
-    data_l = ((cmd << 4) & 0xf0); // Lower nibble of the command
-    
-    data_t[0] = data_u | 0x0C; // Enable (EN) = 1, Register Select (RS) = 0
-    data_t[1] = data_u | 0x08; // Enable (EN) = 0, Register Select (RS) = 0
-    data_t[2] = data_l | 0x0C; // Enable (EN) = 1, Register Select (RS) = 0
-    data_t[3] = data_l | 0x08; // Enable (EN) = 0, Register Select (RS) = 0
-    
-    // Write data to the I2C device
-    err = i2c_master_write_to_device(I2C_NUM, SLAVE_ADDRESS_LCD, data_t, 4, 1000);
-    
+
+    esp_err_t ret = lcd_wait_ready(lcd);
+    if (ret != ESP_OK) return ret;
+
+    data_u = (value & 0xf0);        // Upper nibble
+    data_l = ((value << 4) & 0xf0); // Lower nibble
+
+    data_t[0] = data_u | lcd->backlight | rs | LCD_PIN_EN; // Enable (EN) = 1
+    data_t[1] = data_u | lcd->backlight | rs;              // Enable (EN) = 0
+    data_t[2] = data_l | lcd->backlight | rs | LCD_PIN_EN; // Enable (EN) = 1
+    data_t[3] = data_l | lcd->backlight | rs;              // Enable (EN) = 0
+
+    return lcd_write(lcd, data_t, 4);
+}
+
+esp_err_t lcd_send_cmd(lcd_handle_t *lcd, uint8_t cmd)
+{
+    esp_err_t ret = lcd_send_byte(lcd, cmd, 0);
+
     // Log an error message if there is an error in sending the command
-    if (err != 0) ESP_LOGI(TAG, "Error in sending command");
+    if (ret != ESP_OK) ESP_LOGE(TAG, "Error in sending command 0x%02X", cmd);
+
+    // Clear display and return home are the only instructions slower than an I2C transfer
+    if (ret == ESP_OK && cmd != 0 && (cmd & 0xfc) == 0)
+    {
+        lcd->pending_us = LCD_EXEC_TIME_CLEAR_US;
+        lcd->pending_since = esp_timer_get_time();
+    }
+    return ret;
 }
 
-void lcd_send_data(char data)
+esp_err_t lcd_send_data(lcd_handle_t *lcd, uint8_t data)
 {
-    char data_u, data_l;
-    uint8_t data_t[4];
-    
-    data_u = (data & 0xf0); // Upper nibble of the data
-    data_l = ((data << 4) & 0xf0); // Lower nibble of the data
-    
-    data_t[0] = data_u | 0x0D; // Enable (EN) = 1, Register Select (RS) = 1
-    data_t[1] = data_u | 0x09; // Enable (EN) = 0, Register Select (RS) = 1
-    data_t[2] = data_l | 0x0D; // Enable (EN) = 1, Register Select (RS) = 1
-    data_t[3] = data_l | 0x09; // Enable (EN) = 0, Register Select (RS) = 1
-    
-    // Write data to the I2C device
-    err = i2c_master_write_to_device(I2C_NUM, SLAVE_ADDRESS_LCD, data_t, 4, 1000);
-    
+    esp_err_t ret = lcd_send_byte(lcd, data, LCD_PIN_RS);
+
     // Log an error message if there is an error in sending the data
-    if (err != 0) ESP_LOGI(TAG, "Error in sending data");
+    if (ret != ESP_OK) ESP_LOGE(TAG, "Error in sending data");
+    return ret;
 }
 
-void lcd_clear(void)
+esp_err_t lcd_clear(lcd_handle_t *lcd)
 {
-    lcd_send_cmd(LCD_CMD_CLEAR_DISPLAY); // Clear display command
-    usleep(5000); // Wait for the command to execute
+    return lcd_send_cmd(lcd, LCD_CMD_CLEAR_DISPLAY); // Clear display command, waited for on the next write
 }
 
-void lcd_put_cursor(int row, int col)
+esp_err_t lcd_put_cursor(lcd_handle_t *lcd, int row, int col)
 {
-    switch (row)
-    {
-        case 0:
-            col |= LCD_CMD_SET_CURSOR; // Set position for row 0
-            break;
-        case 1:
-            col |= (LCD_CMD_SET_CURSOR | 0x40); // Set position for row 1
-            break;
-    }
+    if (row < 0 || row >= lcd->rows || col < 0 || col >= lcd->cols) return ESP_ERR_INVALID_ARG;
 
-    lcd_send_cmd(col); // Send command to set cursor position
+    return lcd_send_cmd(lcd, LCD_CMD_SET_CURSOR | (lcd_row_offsets[row] + col)); // Send command to set cursor position
 }
 
-void lcd_init(void)
+esp_err_t lcd_init(i2c_master_bus_handle_t i2c_master_bus, lcd_config_t lcd_config, lcd_handle_t *lcd)
 {
-    i2c_master_init(); // Initialize I2C master interface
+    if (lcd == NULL || lcd_config.i2c_scl_speed_hz > 400000 || lcd_config.rows < 1 || lcd_config.rows > 4 || lcd_config.cols < 1 || lcd_config.cols > 40)
+    {
+        ESP_LOGE(TAG, "Invalid LCD configuration, 'i2c_scl_speed_hz' must be less than or equal to 400000, 'rows' must be between 1 and 4, 'cols' between 1 and 40");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = i2c_master_probe(i2c_master_bus, lcd_config.i2c_device_address, I2C_MASTER_TIMEOUT_MS);
+    if (ret != ESP_OK)
+    {
+        if (ret == ESP_ERR_NOT_FOUND)
+            ESP_LOGE(TAG, "LCD not found in address 0x%02X", lcd_config.i2c_device_address);
+        else
+            ESP_LOGE(TAG, "Error probing LCD in address 0x%02X: %s", lcd_config.i2c_device_address, esp_err_to_name(ret));
+        return ret;
+    }
 
-    // 4-bit initialization sequence
+    i2c_device_config_t i2c_device_config = {
+        .dev_addr_length = I2C_ADDR_BIT_7,
+        .device_address = lcd_config.i2c_device_address,
+        .scl_speed_hz = lcd_config.i2c_scl_speed_hz};
+    ret = i2c_master_bus_add_device(i2c_master_bus, &i2c_device_config, &lcd->i2c_master_dev);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to add LCD 0x%02X to the I2C bus", lcd_config.i2c_device_address);
+        return ret;
+    }
+
+    lcd->backlight = LCD_PIN_BL;
+    lcd->rows = lcd_config.rows;
+    lcd->cols = lcd_config.cols;
+    lcd->busy_flag = false;
+    lcd->pending_us = 0;
+    memset(&lcd->latency, 0, sizeof(lcd->latency));
+
+    // 4-bit initialization sequence. The controller powers up in 8-bit mode, so each
+    // of these is a single nibble: sending full bytes here would leave the 4-bit
+    // interface one nibble out of step.
     usleep(50000); // Wait for >40ms
-    lcd_send_cmd(LCD_CMD_INIT_8_BIT_MODE);
+    ret = lcd_send_nibble(lcd, LCD_CMD_INIT_8_BIT_MODE);
     usleep(5000);  // Wait for >4.1ms
-    lcd_send_cmd(LCD_CMD_INIT_8_BIT_MODE);
+    if (ret == ESP_OK) ret = lcd_send_nibble(lcd, LCD_CMD_INIT_8_BIT_MODE);
     usleep(200);  // Wait for >100us
-    lcd_send_cmd(LCD_CMD_INIT_8_BIT_MODE);
+    if (ret == ESP_OK) ret = lcd_send_nibble(lcd, LCD_CMD_INIT_8_BIT_MODE);
     usleep(10000);
-    lcd_send_cmd(LCD_CMD_INIT_4_BIT_MODE);  // Set 4-bit mode
+    if (ret == ESP_OK) ret = lcd_send_nibble(lcd, LCD_CMD_INIT_4_BIT_MODE);  // Set 4-bit mode
     usleep(10000);
 
-    // Display initialization
-    lcd_send_cmd(LCD_CMD_FUNCTION_SET); // Function set: 4-bit mode, 2-line display, 5x8 characters
-    usleep(1000);
-    lcd_send_cmd(LCD_CMD_DISPLAY_OFF); // Display off
-    usleep(1000);
-    lcd_send_cmd(LCD_CMD_CLEAR_DISPLAY);  // Clear display
-    usleep(1000);
-    lcd_send_cmd(LCD_CMD_ENTRY_MODE_SET); // Entry mode set: increment cursor, no shift
-    usleep(1000);
-    lcd_send_cmd(LCD_CMD_DISPLAY_ON); // Display on, cursor off, blink off
-    usleep(1000);
+    // Display initialization. These instructions take 37us, less than one I2C transfer
+    if (ret == ESP_OK) ret = lcd_send_cmd(lcd, LCD_CMD_FUNCTION_SET); // Function set: 4-bit mode, 2-line display, 5x8 characters
+    if (ret == ESP_OK) ret = lcd_send_cmd(lcd, LCD_CMD_DISPLAY_OFF); // Display off
+    usleep(100);
+
+    // The controller is idle now, so the busy flag must read 0. If R/W is not wired to the
+    // PCF8574 the data lines read back as written (BF = 1) and fixed delays are used instead.
+    if (ret == ESP_OK && lcd_config.busy_flag_polling)
+    {
+        bool busy = true;
+        ret = lcd_read_busy(lcd, &busy);
+        lcd->busy_flag = (ret == ESP_OK && !busy);
+        if (!lcd->busy_flag)
+            ESP_LOGW(TAG, "LCD 0x%02X busy flag not readable, using fixed delays", lcd_config.i2c_device_address);
+    }
+
+    if (ret == ESP_OK) ret = lcd_send_cmd(lcd, LCD_CMD_CLEAR_DISPLAY);  // Clear display
+    if (ret == ESP_OK) ret = lcd_send_cmd(lcd, LCD_CMD_ENTRY_MODE_SET); // Entry mode set: increment cursor, no shift
+    if (ret == ESP_OK) ret = lcd_send_cmd(lcd, LCD_CMD_DISPLAY_ON); // Display on, cursor off, blink off
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to initialize LCD 0x%02X", lcd_config.i2c_device_address);
+        i2c_master_bus_rm_device(lcd->i2c_master_dev);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "LCD %dx%d initialized in address 0x%02X (%s)", lcd->cols, lcd->rows, lcd_config.i2c_device_address,
+             lcd->busy_flag ? "busy flag polling" : "fixed delays");
+    return ESP_OK;
+}
+
+esp_err_t lcd_deinit(lcd_handle_t *lcd)
+{
+    esp_err_t ret = i2c_master_bus_rm_device(lcd->i2c_master_dev);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to remove LCD from the I2C bus");
+        return ret;
+    }
+    lcd->i2c_master_dev = NULL;
+
+    return ESP_OK;
 }
 
-void lcd_send_string(char *str)
+esp_err_t lcd_send_string(lcd_handle_t *lcd, const char *str)
 {
-    while (*str) lcd_send_data(*str++); // Send each character of the string
+    esp_err_t ret = ESP_OK;
+
+    while (*str && ret == ESP_OK) ret = lcd_send_data(lcd, *str++); // Send each character of the string
+    return ret;
+}
+
+void lcd_log_latency_stats(const lcd_handle_t *lcd)
+{
+    const lcd_latency_stats_t *stats = &lcd->latency;
+
+    if (stats->count == 0)
+    {
+        ESP_LOGI(TAG, "No slow commands sent yet");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Command latency (%s): %lu commands, min %lu us, avg %lu us, max %lu us, %lu busy flag reads",
+             lcd->busy_flag ? "busy flag polling" : "fixed delays", (unsigned long)stats->count,
+             (unsigned long)stats->min_us, (unsigned long)(stats->total_us / stats->count),
+             (unsigned long)stats->max_us, (unsigned long)stats->polls);
+    for (int i = 0; i < LCD_LATENCY_BUCKETS; i++)
+    {
+        if (stats->histogram[i] == 0) continue;
+        if (i < LCD_LATENCY_BUCKETS - 1)
+            ESP_LOGI(TAG, "  < %5u us: %lu", lcd_latency_bounds_us[i], (unsigned long)stats->histogram[i]);
+        else
+            ESP_LOGI(TAG, "  >= %4u us: %lu", lcd_latency_bounds_us[i - 1], (unsigned long)stats->histogram[i]);
+    }
 }
@@ -1,32 +1,37 @@
 #ifndef I2C_LCD_H
 #define I2C_LCD_H
 
-// I2C address of the LCD (change according to your setup)
-#define SLAVE_ADDRESS_LCD 0x27    
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+// Default I2C address of the PCF8574 backpack (0x3F on PCF8574A based modules)
+#define LCD_DEFAULT_ADDRESS         0x27
 
 // GPIO number used for I2C master clock
-#define I2C_MASTER_SCL_IO           GPIO_NUM_22      
+#define I2C_MASTER_SCL_IO           GPIO_NUM_22
 
 // GPIO number used for I2C master data
-#define I2C_MASTER_SDA_IO           GPIO_NUM_21      
+#define I2C_MASTER_SDA_IO           GPIO_NUM_21
 
 // I2C master port number (number of I2C peripheral interfaces available depends on the chip)
-#define I2C_MASTER_NUM              0                
+#define I2C_MASTER_NUM              0
 
 // I2C master clock frequency
-#define I2C_MASTER_FREQ_HZ          400000           
-
-// I2C master doesn't need buffer for transmission
-#define I2C_MASTER_TX_BUF_DISABLE   0                
-
-// I2C master doesn't need buffer for reception
-#define I2C_MASTER_RX_BUF_DISABLE   0                
+#define I2C_MASTER_FREQ_HZ          400000
 
 // Timeout for I2C master in milliseconds
 #define I2C_MASTER_TIMEOUT_MS       1000
 
-// Define the I2C number to be used
-#define I2C_NUM                     I2C_NUM_0
+// Worst-case execution time of clear display / return home (1.52 ms in the datasheet)
+#define LCD_EXEC_TIME_CLEAR_US      2000
+
+// Busy flag polling gives up and falls back to fixed delays after this time
+#define LCD_BUSY_TIMEOUT_US         10000
+
+// Number of buckets of the command latency histogram
+#define LCD_LATENCY_BUCKETS         8
 
 // LCD command definitions
 #define LCD_CMD_CLEAR_DISPLAY 0x01
@@ -38,56 +43,137 @@
 #define LCD_CMD_SET_CURSOR 0x80
 #define LCD_CMD_INIT_8_BIT_MODE 0x30
 #define LCD_CMD_INIT_4_BIT_MODE 0x20
+#define LCD_CMD_SHIFT_DISPLAY_LEFT 0x18
+#define LCD_CMD_SHIFT_DISPLAY_RIGHT 0x1C
+
+/**
+ * @brief Configuration for one I2C LCD.
+ *
+ * Several LCDs can share the same I2C master bus as long as their backpacks use different addresses.
+ */
+typedef struct
+{
+    uint16_t i2c_device_address;
+    uint32_t i2c_scl_speed_hz;
+    uint8_t rows;
+    uint8_t cols;
+    bool busy_flag_polling; // Read the busy flag instead of waiting worst-case times (needs R/W wired to the PCF8574)
+} lcd_config_t;
+
+/**
+ * @brief Latency distribution of the slow LCD commands.
+ *
+ * Time from the end of a clear display / return home transfer until the first busy flag read
+ * that found the controller idle; with fixed delays, the worst-case time that was waited.
+ * Polling starts at the next write, so a command followed by a longer pause reads as that pause.
+ * Bucket i counts latencies below 100, 200, 500, 1000, 1500, 2000 and 5000 us; the last one the rest.
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t polls;
+    uint32_t histogram[LCD_LATENCY_BUCKETS];
+} lcd_latency_stats_t;
+
+/**
+ * @brief Handle for one I2C LCD.
+ *
+ * Holds the I2C device handle, created once in lcd_init() and reused by every transfer,
+ * the geometry of the display and the state of the last slow command. The wait for a slow
+ * command is deferred until the next write, so the caller can do other work meanwhile.
+ */
+typedef struct
+{
+    i2c_master_dev_handle_t i2c_master_dev;
+    uint8_t backlight;
+    uint8_t rows;
+    uint8_t cols;
+    bool busy_flag;          // True while busy flag polling is in use
+    uint32_t pending_us;     // Worst-case time the last command may still need
+    int64_t pending_since;   // esp_timer time at which that command was sent
+    lcd_latency_stats_t latency;
+} lcd_handle_t;
 
 /**
  * @brief Initializes the LCD
- * 
- * This function sets up the LCD for use, initializing the required configurations.
+ *
+ * @param i2c_master_bus An initialized I2C master bus handle, possibly shared with other devices
+ * @param lcd_config     Address, bus speed and geometry of the display
+ * @param lcd            Pointer to the LCD handle to be initialized
+ *
+ * @return
+ *   - ESP_OK on success.
+ *   - ESP_ERR_INVALID_ARG if the configuration is invalid.
+ *   - ESP_ERR_NOT_FOUND if no device answers at the configured address.
+ *   - Other errors from the I2C driver.
+ */
+esp_err_t lcd_init(i2c_master_bus_handle_t i2c_master_bus, lcd_config_t lcd_config, lcd_handle_t *lcd);
+
+/**
+ * @brief Removes the LCD from the I2C bus
+ *
+ * @param lcd Pointer to the LCD handle
  */
-void lcd_init(void);   
+esp_err_t lcd_deinit(lcd_handle_t *lcd);
 
 /**
  * @brief Sends a command to the LCD
- * 
+ *
+ * @param lcd Pointer to the LCD handle
  * @param cmd The command to send to the LCD
- * 
+ *
  * This function sends a command to the LCD to perform various control operations.
  */
-void lcd_send_cmd(char cmd);  
+esp_err_t lcd_send_cmd(lcd_handle_t *lcd, uint8_t cmd);
 
 /**
  * @brief Sends data to the LCD
- * 
+ *
+ * @param lcd  Pointer to the LCD handle
  * @param data The data to send to the LCD
- * 
+ *
  * This function sends a data byte to the LCD, which is displayed on the screen.
  */
-void lcd_send_data(char data);  
+esp_err_t lcd_send_data(lcd_handle_t *lcd, uint8_t data);
 
 /**
  * @brief Sends a string to the LCD
- * 
+ *
+ * @param lcd Pointer to the LCD handle
  * @param str The string to send to the LCD
- * 
+ *
  * This function sends a null-terminated string to the LCD to be displayed.
  */
-void lcd_send_string(char *str);  
+esp_err_t lcd_send_string(lcd_handle_t *lcd, const char *str);
 
 /**
  * @brief Sets the cursor position on the LCD
- * 
- * @param row The row number (0 or 1)
- * @param col The column number (0-15)
- * 
+ *
+ * @param lcd Pointer to the LCD handle
+ * @param row The row number (0 to rows - 1)
+ * @param col The column number (0 to cols - 1)
+ *
  * This function positions the cursor on the LCD at the specified row and column.
  */
-void lcd_put_cursor(int row, int col); 
+esp_err_t lcd_put_cursor(lcd_handle_t *lcd, int row, int col);
 
 /**
  * @brief Clears the LCD screen
- * 
+ *
+ * @param lcd Pointer to the LCD handle
+ *
  * This function clears all the content displayed on the LCD and resets the cursor position.
  */
-void lcd_clear(void);
+esp_err_t lcd_clear(lcd_handle_t *lcd);
+
+/**
+ * @brief Logs the latency distribution of the slow commands sent to the LCD
+ *
+ * @param lcd Pointer to the LCD handle
+ */
+void lcd_log_latency_stats(const lcd_handle_t *lcd);
 
 #endif /* I2C_LCD_H */
@@ -0,0 +1,52 @@
+#include "lcd_marquee.h"
+#include "esp_log.h"
+
+static const char *TAG = "LCD_MARQUEE"; // Tag for logging
+
+// Writes a full 40-character DDRAM line, padding with spaces
+static esp_err_t lcd_marquee_write_line(lcd_handle_t *lcd, int row, const char *text)
+{
+    esp_err_t ret = lcd_put_cursor(lcd, row, 0);
+
+    for (int i = 0; i < LCD_MARQUEE_LINE_LEN && ret == ESP_OK; i++)
+    {
+        char c = ' ';
+        if (text && *text) c = *text++;
+        ret = lcd_send_data(lcd, c);
+    }
+    return ret;
+}
+
+esp_err_t lcd_marquee_load(lcd_marquee_t *marquee, lcd_handle_t *lcd, const char *line0, const char *line1)
+{
+    if (marquee == NULL || lcd == NULL || lcd->rows > 2)
+    {
+        ESP_LOGE(TAG, "Invalid marquee arguments, the LCD must have 1 or 2 rows");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    marquee->lcd = lcd;
+    marquee->offset = 0;
+
+    // Return home undoes any previous display shift
+    esp_err_t ret = lcd_send_cmd(lcd, LCD_CMD_RETURN_HOME);
+    if (ret == ESP_OK) ret = lcd_marquee_write_line(lcd, 0, line0);
+    if (ret == ESP_OK && lcd->rows == 2) ret = lcd_marquee_write_line(lcd, 1, line1);
+
+    if (ret != ESP_OK) ESP_LOGE(TAG, "Failed to load marquee text");
+    return ret;
+}
+
+esp_err_t lcd_marquee_step(lcd_marquee_t *marquee)
+{
+    esp_err_t ret = lcd_send_cmd(marquee->lcd, LCD_CMD_SHIFT_DISPLAY_LEFT);
+    if (ret == ESP_OK) marquee->offset = (marquee->offset + 1) % LCD_MARQUEE_LINE_LEN;
+    return ret;
+}
+
+esp_err_t lcd_marquee_reset(lcd_marquee_t *marquee)
+{
+    esp_err_t ret = lcd_send_cmd(marquee->lcd, LCD_CMD_RETURN_HOME);
+    if (ret == ESP_OK) marquee->offset = 0;
+    return ret;
+}
@@ -0,0 +1,51 @@
+#ifndef LCD_MARQUEE_H
+#define LCD_MARQUEE_H
+
+#include <stdint.h>
+#include "i2c_lcd.h"
+
+// Characters per line held in the HD44780 DDRAM (the display shows a window of 'cols' of them)
+#define LCD_MARQUEE_LINE_LEN 40
+
+/**
+ * @brief Marquee state for one LCD.
+ *
+ * The text is loaded into DDRAM once and scrolled with the display shift instruction,
+ * so each step costs one command (5 bytes on the I2C bus: address and 4 data bytes) instead of
+ * rewriting a line.
+ * The HD44780 shifts both lines together, so the two lines always scroll in step.
+ */
+typedef struct
+{
+    lcd_handle_t *lcd;
+    uint8_t offset; // Current display shift, 0 to LCD_MARQUEE_LINE_LEN - 1
+} lcd_marquee_t;
+
+/**
+ * @brief Loads up to 40 characters per line into DDRAM and resets the display shift
+ *
+ * @param marquee Pointer to the marquee state to initialize
+ * @param lcd     Pointer to an initialized LCD handle (1 or 2 rows)
+ * @param line0   Text of the first line, NULL to leave it blank
+ * @param line1   Text of the second line, NULL to leave it blank
+ *
+ * Lines are padded with spaces to 40 characters so the text wraps around with a gap.
+ * Longer lines are truncated.
+ */
+esp_err_t lcd_marquee_load(lcd_marquee_t *marquee, lcd_handle_t *lcd, const char *line0, const char *line1);
+
+/**
+ * @brief Scrolls the text one position to the left
+ *
+ * @param marquee Pointer to the marquee state
+ */
+esp_err_t lcd_marquee_step(lcd_marquee_t *marquee);
+
+/**
+ * @brief Scrolls the text back to its first character (return home)
+ *
+ * @param marquee Pointer to the marquee state
+ */
+esp_err_t lcd_marquee_reset(lcd_marquee_t *marquee);
+
+#endif /* LCD_MARQUEE_H */
@@ -17,8 +17,10 @@
 
 #include <stdio.h>
 #include <string.h>
-#include "driver/i2c.h"
+#include <time.h>
+#include "driver/i2c_master.h"
 #include "i2c_lcd.h"
+#include "lcd_marquee.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -26,46 +28,104 @@
 // Etiqueta para mensajes de log
 static const char *TAG = "LCD_16x2";
 
+// Intervalo entre pasos del texto desplazable (ms)
+#define MARQUEE_STEP_MS 300
+
+// Dirección de una segunda pantalla opcional en el mismo bus (módulos PCF8574A)
+#define LCD2_ADDRESS 0x3F
+
+// Bus I2C compartido por todas las pantallas (y por cualquier otro dispositivo)
+static i2c_master_bus_handle_t i2c_master_bus;
+
+static const i2c_master_bus_config_t i2c_master_bus_config = {
+    .i2c_port = I2C_MASTER_NUM,
+    .scl_io_num = I2C_MASTER_SCL_IO,
+    .sda_io_num = I2C_MASTER_SDA_IO,
+    .clk_source = I2C_CLK_SRC_DEFAULT,
+    .glitch_ignore_cnt = 7,
+    .flags.enable_internal_pullup = true};
+
+static lcd_handle_t lcd1;
+static lcd_handle_t lcd2;
+
+void mostrar_bienvenida(lcd_handle_t *lcd, const char *nombre);
+
 /**
  * @brief Función principal de la aplicación
  */
 void app_main(void)
 {
     ESP_LOGI(TAG, "Iniciando ejemplo de LCD 16x2 con I2C");
-    
+
+    // Crear el bus I2C una sola vez; cada pantalla se añade como un dispositivo más
+    esp_err_t ret = i2c_new_master_bus(&i2c_master_bus_config, &i2c_master_bus);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error al crear el bus I2C: %s", esp_err_to_name(ret));
+        vTaskDelay(portMAX_DELAY);
+    }
+
+    lcd_config_t lcd_config = {
+        .i2c_device_address = LCD_DEFAULT_ADDRESS,
+        .i2c_scl_speed_hz = I2C_MASTER_FREQ_HZ,
+        .rows = 2,
+        .cols = 16,
+        .busy_flag_polling = true}; // Si R/W no está cableado se usan retardos fijos
+
     // Inicializar la pantalla LCD
-    esp_err_t ret = lcd_init();
+    ret = lcd_init(i2c_master_bus, lcd_config, &lcd1);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error al inicializar la pantalla LCD: %s", esp_err_to_name(ret));
         vTaskDelay(portMAX_DELAY);
     }
-    
+
+    // La segunda pantalla es opcional: si no responde se continúa solo con la primera
+    lcd_config.i2c_device_address = LCD2_ADDRESS;
+    bool lcd2_ok = lcd_init(i2c_master_bus, lcd_config, &lcd2) == ESP_OK;
+    if (!lcd2_ok) {
+        ESP_LOGW(TAG, "No hay segunda pantalla en la dirección 0x%02X", LCD2_ADDRESS);
+    }
+
     // Limpiar la pantalla LCD
-    lcd_clear();
-    
+    lcd_clear(&lcd1);
+
     // Mostrar mensaje en la primera línea
-    lcd_put_cursor(0, 0);
-    lcd_send_string("Hola, ESP32!");
-    
+    lcd_put_cursor(&lcd1, 0, 0);
+    lcd_send_string(&lcd1, "Hola, ESP32!");
+
     // Mostrar mensaje en la segunda línea
-    lcd_put_cursor(1, 0);
-    lcd_send_string("LCD 16x2 I2C");
-    
+    lcd_put_cursor(&lcd1, 1, 0);
+    lcd_send_string(&lcd1, "LCD 16x2 I2C");
+
+    if (lcd2_ok) {
+        mostrar_bienvenida(&lcd2, "Pantalla 2");
+    }
+
     ESP_LOGI(TAG, "Mensajes mostrados en la pantalla LCD");
-    
+
+    // Distribución de latencias de los comandos lentos (borrar pantalla, volver al inicio)
+    lcd_log_latency_stats(&lcd1);
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+
+    // Cargar una sola vez un texto de hasta 40 caracteres por línea en la DDRAM;
+    // cada paso del bucle es un único comando de desplazamiento de pantalla
+    lcd_marquee_t marquee;
+    lcd_marquee_load(&marquee, &lcd1, "Texto largo que no cabe en 16 columnas", "Desplazamiento por hardware");
+
     // Bucle principal (no se sale de la función app_main)
     while (1) {
-        // Aquí podrías actualizar la pantalla periódicamente si fuera necesario
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        lcd_marquee_step(&marquee);
+        vTaskDelay(MARQUEE_STEP_MS / portTICK_PERIOD_MS);
     }
 }
 
 /**
  * @brief Función para mostrar un mensaje de bienvenida personalizado
  * 
+ * @param lcd Pantalla en la que se muestra el mensaje
  * @param nombre Nombre a mostrar en el mensaje de bienvenida
  */
-void mostrar_bienvenida(const char *nombre)
+void mostrar_bienvenida(lcd_handle_t *lcd, const char *nombre)
 {
     char mensaje[17];  // 16 caracteres + carácter nulo
     
@@ -74,11 +134,11 @@ void mostrar_bienvenida(const char *nombre)
     mensaje[16] = '\0';
     
     // Mostrar mensaje de bienvenida
-    lcd_clear();
-    lcd_put_cursor(0, 0);
-    lcd_send_string("Bienvenido:");
-    lcd_put_cursor(1, 0);
-    lcd_send_string(mensaje);
+    lcd_clear(lcd);
+    lcd_put_cursor(lcd, 0, 0);
+    lcd_send_string(lcd, "Bienvenido:");
+    lcd_put_cursor(lcd, 1, 0);
+    lcd_send_string(lcd, mensaje);
     
     ESP_LOGI(TAG, "Mensaje de bienvenida mostrado para: %s", nombre);
 }
@@ -86,9 +146,10 @@ void mostrar_bienvenida(const char *nombre)
 /**
  * @brief Función para mostrar la hora actual en la pantalla LCD
  * 
+ * @param lcd Pantalla en la que se muestra la hora
  * @param hora Puntero a la estructura tm con la hora actual
  */
-void mostrar_hora(const struct tm *hora)
+void mostrar_hora(lcd_handle_t *lcd, const struct tm *hora)
 {
     char tiempo[17];  // Formato: "HH:MM:SS DD/MM/YY"
     
@@ -103,6 +164,6 @@ void mostrar_hora(const struct tm *hora)
              hora->tm_mday, hora->tm_mon + 1, hora->tm_year % 100);
     
     // Mostrar en la segunda línea
-    lcd_put_cursor(1, 0);
-    lcd_send_string(tiempo);
+    lcd_put_cursor(lcd, 1, 0);
+    lcd_send_string(lcd, tiempo);
 }
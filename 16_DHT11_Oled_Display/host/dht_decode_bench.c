@@ -0,0 +1,49 @@
+/**
+ * Archivo: dht_decode_bench.c
+ * Descripción: Mide en el PC el tiempo de dht_edges_to_pulses() y dht_decode() sobre una captura
+ *              completa (85 flancos, 42 celdas). Sirve para comparar cambios del decodificador; en el
+ *              ESP32 el tiempo absoluto es mayor, pero la proporción entre versiones se mantiene.
+ *
+ * Uso: ./dht_decode_bench [iteraciones]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "dht_decode.h"
+#include "dht_traces.h"
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    const uint8_t raw[5] = { 0x02, 0x8c, 0x80, 0x65, 0x73 };
+    dht_pulse_t pulses[DHT_TRACE_CELLS];
+    dht_pulse_t cells[DHT_TRACE_CELLS];
+    int64_t time[DHT_TRACE_EDGES];
+    uint8_t level[DHT_TRACE_EDGES];
+    dht_reading_t reading;
+    volatile unsigned sink = 0;     // Keeps the calls from being optimized away
+
+    size_t count = dht_trace_build(raw, 100, pulses);
+    size_t edges = dht_trace_to_edges(pulses, count, time, level);
+
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) sink += dht_edges_to_pulses(time, level, edges, cells);
+    double edges_ns = (now_ns() - start) / iterations;
+
+    start = now_ns();
+    for (long i = 0; i < iterations; i++) sink += dht_decode(pulses, count, DHT_TYPE_DHT22, &reading) + reading.raw[4];
+    double decode_ns = (now_ns() - start) / iterations;
+
+    printf("dht_edges_to_pulses: %.1f ns por captura (%zu flancos)\n", edges_ns, edges);
+    printf("dht_decode:          %.1f ns por trama (%zu celdas)\n", decode_ns, count);
+    printf("%ld iteraciones\n", iterations);
+    return sink == 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * Archivo: dht_decode_fuzz.c
+ * Descripción: Punto de entrada de fuzzing para dht_decode() y dht_edges_to_pulses(). Los bytes de
+ *              entrada se interpretan como celdas de bit (pares de uint16) y como flancos
+ *              (incremento de tiempo + nivel), y se comprueban invariantes: estado válido, número de
+ *              celdas acotado y, si la trama es correcta, suma de comprobación y rangos coherentes.
+ *
+ * Uso con libFuzzer (clang):
+ *      clang -g -O1 -fsanitize=fuzzer,address,undefined -Imain host/dht_decode_fuzz.c main/dht_decode.c
+ * Sin libFuzzer (gcc), con -DDHT_FUZZ_STANDALONE se ejecutan entradas pseudoaleatorias:
+ *      ./dht_decode_fuzz [iteraciones]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dht_decode.h"
+
+// Entradas mayores se recortan: las capturas reales no pasan de unas 90 celdas
+#define FUZZ_MAX_CELLS 128
+
+static void check(int cond, const char *what)
+{
+    if (!cond)
+    {
+        fprintf(stderr, "invariante violado: %s\n", what);
+        abort();
+    }
+}
+
+static void check_decode(const dht_pulse_t *pulses, size_t count, dht_sensor_type_t type)
+{
+    dht_reading_t reading;
+    dht_decode_status_t status = dht_decode(pulses, count, type, &reading);
+
+    check(status >= DHT_DECODE_OK && status <= DHT_DECODE_CHECKSUM, "estado fuera de rango");
+    check(count >= DHT_DECODE_BITS || status == DHT_DECODE_INCOMPLETE, "trama corta no detectada");
+    if (status != DHT_DECODE_OK) return;
+
+    const uint8_t *raw = reading.raw;
+    check(((raw[0] + raw[1] + raw[2] + raw[3]) & 0xff) == raw[4], "suma de comprobación aceptada");
+    check(reading.humidity >= 0.0f && reading.humidity <= 6553.5f, "humedad fuera de rango");
+    check(reading.temperature >= -3276.7f && reading.temperature <= 3276.7f, "temperatura fuera de rango");
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    dht_pulse_t pulses[FUZZ_MAX_CELLS];
+    size_t count = size / sizeof(dht_pulse_t);
+    if (count > FUZZ_MAX_CELLS) count = FUZZ_MAX_CELLS;
+    memcpy(pulses, data, count * sizeof(dht_pulse_t));
+
+    check_decode(pulses, count, DHT_TYPE_DHT11);
+    check_decode(pulses, count, DHT_TYPE_DHT22);
+
+    // The same bytes as edges: one byte of time step and one of level per edge
+    int64_t time[2 * FUZZ_MAX_CELLS];
+    uint8_t level[2 * FUZZ_MAX_CELLS];
+    size_t edges = size / 2;
+    if (edges > 2 * FUZZ_MAX_CELLS) edges = 2 * FUZZ_MAX_CELLS;
+
+    int64_t t = 0;
+    for (size_t i = 0; i < edges; i++)
+    {
+        t += data[2 * i];
+        time[i] = t;
+        level[i] = data[2 * i + 1] & 1;
+    }
+
+    size_t cells = dht_edges_to_pulses(time, level, edges, pulses);
+    check(cells <= edges / 2, "más celdas que pares de flancos");
+    check_decode(pulses, cells, DHT_TYPE_DHT22);
+    return 0;
+}
+
+#ifdef DHT_FUZZ_STANDALONE
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 100000;
+    uint8_t data[FUZZ_MAX_CELLS * sizeof(dht_pulse_t)];
+
+    srand(1);
+    for (long i = 0; i < iterations; i++)
+    {
+        size_t size = rand() % (sizeof(data) + 1);
+        for (size_t j = 0; j < size; j++)
+        {
+            // Mostly plausible widths so that some inputs get past the pulse checks
+            data[j] = (j & 1) ? 0 : (uint8_t)(rand() % 2 ? 20 + rand() % 60 : rand());
+        }
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    printf("%ld entradas sin violar invariantes\n", iterations);
+    return 0;
+}
+#endif
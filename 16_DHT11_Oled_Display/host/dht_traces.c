@@ -0,0 +1,49 @@
+#include "dht_traces.h"
+
+// Jitter added to successive widths, in us (interrupt latency and sensor clock drift)
+static const int8_t jitter_us[] = { 0, 3, -2, 1, -4, 2, 0, -1, 4, -3 };
+
+static uint16_t width(int us, int scale_pct, size_t n)
+{
+    int w = (us + jitter_us[n % sizeof(jitter_us)]) * scale_pct / 100;
+    return w < 1 ? 1 : w;
+}
+
+size_t dht_trace_build(const uint8_t raw[5], int scale_pct, dht_pulse_t *pulses)
+{
+    size_t n = 0;
+
+    // The line is released by the host, then the sensor answers with 80 us low + 80 us high
+    pulses[n] = (dht_pulse_t){ width(20, scale_pct, n), width(30, scale_pct, n + 1) };
+    n++;
+    pulses[n] = (dht_pulse_t){ width(80, scale_pct, n), width(80, scale_pct, n + 1) };
+    n++;
+
+    for (int i = 0; i < DHT_DECODE_BITS; i++, n++)
+    {
+        int bit = (raw[i / 8] >> (7 - i % 8)) & 1;
+        pulses[n].low_us = width(50, scale_pct, n);
+        pulses[n].high_us = width(bit ? 70 : 26, scale_pct, n + 3);
+    }
+    return n;
+}
+
+size_t dht_trace_to_edges(const dht_pulse_t *pulses, size_t count, int64_t *time, uint8_t *level)
+{
+    int64_t t = 1000;
+    size_t n = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        time[n] = t;
+        level[n++] = 0;
+        t += pulses[i].low_us;
+        time[n] = t;
+        level[n++] = 1;
+        t += pulses[i].high_us;
+    }
+    // The sensor pulls the line low once more at the end of the last bit
+    time[n] = t;
+    level[n++] = 0;
+    return n;
+}
@@ -0,0 +1,36 @@
+#ifndef DHT_TRACES_H
+#define DHT_TRACES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dht_decode.h"
+
+// Cells in a full capture: line release, sensor response and the 40 data bits
+#define DHT_TRACE_CELLS (2 + DHT_DECODE_BITS)
+
+// Edges in a full capture: falling, rising and the final falling edge of each cell
+#define DHT_TRACE_EDGES (2 * DHT_TRACE_CELLS + 1)
+
+/**
+ * @brief Builds the bit cells of a DHT capture with the datasheet timings
+ * @note  The host release (20-40 us) and the sensor response (80 us low + 80 us high) come first,
+ *        then the 40 data cells (50 us low, 26 us high for 0 and 70 us high for 1). Every width
+ *        gets a deterministic jitter of a few us, like the readings of a real capture.
+ * @param raw the 5 frame bytes, checksum included
+ * @param scale_pct time base of the capture in % (100 = exact, 130 = 30 % slow)
+ * @param pulses output, room for DHT_TRACE_CELLS cells
+ * @return number of cells written
+*/
+size_t dht_trace_build(const uint8_t raw[5], int scale_pct, dht_pulse_t *pulses);
+
+/**
+ * @brief Converts bit cells into the timestamped edges an interrupt backend records
+ * @param pulses bit cells
+ * @param count number of cells
+ * @param time output timestamps in us, room for 2 * count + 1 edges
+ * @param level output line level after each edge
+ * @return number of edges written
+*/
+size_t dht_trace_to_edges(const dht_pulse_t *pulses, size_t count, int64_t *time, uint8_t *level);
+
+#endif
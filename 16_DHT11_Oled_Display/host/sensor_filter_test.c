@@ -0,0 +1,243 @@
+/**
+ * Archivo: sensor_filter_test.c
+ * Descripción: Pruebas de las etapas de sensor_filter en Linux. Cada etapa se prueba sola con una
+ *              secuencia de entradas y las salidas y resultados esperados: mediana (también mientras
+ *              se llena la ventana), redondeo de la media exponencial con valores positivos y
+ *              negativos, límite de variación (incluido el escalón que se acepta tras N rechazos) e
+ *              histéresis. Al final se comprueba que sensor_filter_check() no cambia el estado y
+ *              que, usado como en main.c, un filtro no se queda con la muestra que rechaza el otro.
+ *
+ * Uso: ./sensor_filter_test
+ *      Devuelve 1 si alguna salida no es la esperada.
+ */
+
+#include <stdio.h>
+#include "sensor_filter.h"
+
+typedef struct
+{
+    sensor_fixed_t in;
+    sensor_filter_result_t result;
+    sensor_fixed_t out;         // Solo se comprueba si el resultado no es REJECT
+} step_t;
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        failures++; \
+        printf("  FALLO: "); printf(__VA_ARGS__); printf("\n"); \
+    } \
+} while (0)
+
+static const char *result_str(sensor_filter_result_t r)
+{
+    return r == SENSOR_FILTER_PASS ? "PASS" : r == SENSOR_FILTER_HOLD ? "HOLD" : "REJECT";
+}
+
+static void run(const char *name, sensor_filter_t *filter, const step_t *steps, size_t count)
+{
+    int before = failures;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sensor_fixed_t out = 0;
+        sensor_filter_result_t r = sensor_filter_process(filter, steps[i].in, &out);
+        CHECK(r == steps[i].result, "%s, paso %zu (%ld): %s, esperado %s", name, i, (long)steps[i].in,
+              result_str(r), result_str(steps[i].result));
+        if (r != SENSOR_FILTER_REJECT && steps[i].result != SENSOR_FILTER_REJECT)
+            CHECK(out == steps[i].out, "%s, paso %zu (%ld): salida %ld, esperada %ld", name, i, (long)steps[i].in,
+                  (long)out, (long)steps[i].out);
+    }
+
+    printf("%-32s %s\n", name, failures == before ? "ok" : "FALLO");
+}
+
+#define RUN(name, filter, steps) run(name, filter, steps, sizeof(steps) / sizeof(steps[0]))
+
+static void test_range(void)
+{
+    static const step_t steps[] = {
+        { -1, SENSOR_FILTER_REJECT, 0 },
+        { 0, SENSOR_FILTER_PASS, 0 },
+        { 5000, SENSOR_FILTER_PASS, 5000 },
+        { 5001, SENSOR_FILTER_REJECT, 0 },
+    };
+    sensor_filter_t f;
+    sensor_filter_init(&f);
+    sensor_filter_add_range(&f, 0, 5000);
+    RUN("rango", &f, steps);
+}
+
+static void test_median(void)
+{
+    // La ventana se llena: 1 valor, media de 2, mediana de 3; después descarta el más antiguo
+    static const step_t steps[] = {
+        { 10, SENSOR_FILTER_PASS, 10 },
+        { 100, SENSOR_FILTER_PASS, 55 },
+        { 20, SENSOR_FILTER_PASS, 20 },
+        { 30, SENSOR_FILTER_PASS, 30 },
+        { 25, SENSOR_FILTER_PASS, 25 },
+        { -500, SENSOR_FILTER_PASS, 25 },
+    };
+    sensor_filter_t f;
+    sensor_filter_init(&f);
+    sensor_filter_add_median(&f, 3);
+    RUN("mediana", &f, steps);
+}
+
+static void test_ema(void)
+{
+    // Con shift 2 el acumulador avanza 1/4 del error: 1000 -> 1003 da 1000.75, 1001.31 y 1001.73
+    static const step_t up[] = {
+        { 1000, SENSOR_FILTER_PASS, 1000 },
+        { 1003, SENSOR_FILTER_PASS, 1001 },
+        { 1003, SENSOR_FILTER_PASS, 1001 },
+        { 1003, SENSOR_FILTER_PASS, 1002 },
+    };
+    // Mismos pasos con el signo cambiado: el redondeo es simétrico
+    static const step_t down[] = {
+        { -1000, SENSOR_FILTER_PASS, -1000 },
+        { -1003, SENSOR_FILTER_PASS, -1001 },
+        { -1003, SENSOR_FILTER_PASS, -1001 },
+        { -1003, SENSOR_FILTER_PASS, -1002 },
+    };
+    // Con shift 0 la salida es la entrada
+    static const step_t none[] = {
+        { 1000, SENSOR_FILTER_PASS, 1000 },
+        { -7, SENSOR_FILTER_PASS, -7 },
+    };
+    sensor_filter_t f;
+
+    sensor_filter_init(&f);
+    sensor_filter_add_ema(&f, 2);
+    RUN("media exponencial (+)", &f, up);
+
+    sensor_filter_init(&f);
+    sensor_filter_add_ema(&f, 2);
+    RUN("media exponencial (-)", &f, down);
+
+    sensor_filter_init(&f);
+    sensor_filter_add_ema(&f, 0);
+    RUN("media exponencial (shift 0)", &f, none);
+
+    CHECK(!sensor_filter_add_ema(&f, 9), "shift 9 aceptado");
+}
+
+static void test_rate(void)
+{
+    // Un pico aislado se descarta y no mueve la referencia
+    static const step_t spike[] = {
+        { 2000, SENSOR_FILTER_PASS, 2000 },
+        { 3000, SENSOR_FILTER_REJECT, 0 },
+        { 2100, SENSOR_FILTER_PASS, 2100 },
+        { 2001, SENSOR_FILTER_PASS, 2001 },
+    };
+    // Un escalón real se acepta tras max_rejects rechazos seguidos
+    static const step_t step[] = {
+        { 2000, SENSOR_FILTER_PASS, 2000 },
+        { 2500, SENSOR_FILTER_REJECT, 0 },
+        { 2500, SENSOR_FILTER_REJECT, 0 },
+        { 2500, SENSOR_FILTER_PASS, 2500 },
+        { 2550, SENSOR_FILTER_PASS, 2550 },
+        { 3000, SENSOR_FILTER_REJECT, 0 },
+        { 2600, SENSOR_FILTER_PASS, 2600 },
+        { 3000, SENSOR_FILTER_REJECT, 0 },
+    };
+    sensor_filter_t f;
+
+    sensor_filter_init(&f);
+    sensor_filter_add_rate(&f, 100, 2);
+    RUN("variación (pico)", &f, spike);
+
+    sensor_filter_init(&f);
+    sensor_filter_add_rate(&f, 100, 2);
+    RUN("variación (escalón)", &f, step);
+}
+
+static void test_hysteresis(void)
+{
+    static const step_t steps[] = {
+        { 1000, SENSOR_FILTER_PASS, 1000 },
+        { 1030, SENSOR_FILTER_HOLD, 1000 },
+        { 1049, SENSOR_FILTER_HOLD, 1000 },
+        { 1050, SENSOR_FILTER_PASS, 1050 },
+        { 1001, SENSOR_FILTER_HOLD, 1050 },
+        { 999, SENSOR_FILTER_PASS, 999 },
+    };
+    sensor_filter_t f;
+    sensor_filter_init(&f);
+    sensor_filter_add_hysteresis(&f, 50);
+    RUN("histéresis", &f, steps);
+}
+
+static void test_check(void)
+{
+    sensor_filter_t f;
+    sensor_fixed_t out;
+    int before = failures;
+
+    sensor_filter_init(&f);
+    sensor_filter_add_range(&f, 0, 5000);
+    sensor_filter_add_rate(&f, 100, 1);
+    sensor_filter_add_median(&f, 3);
+
+    CHECK(sensor_filter_check(&f, 6000) == SENSOR_FILTER_REJECT, "fuera de rango aceptado");
+    CHECK(sensor_filter_check(&f, 2000) == SENSOR_FILTER_PASS, "primera muestra rechazada");
+    sensor_filter_process(&f, 2000, &out);
+
+    // Comprobar varias veces no cuenta rechazos: el salto sigue rechazándose hasta procesarlo
+    for (int i = 0; i < 3; i++)
+        CHECK(sensor_filter_check(&f, 2500) == SENSOR_FILTER_REJECT, "salto aceptado tras %d comprobaciones", i);
+    CHECK(sensor_filter_process(&f, 2500, &out) == SENSOR_FILTER_REJECT, "salto aceptado al procesar");
+    CHECK(sensor_filter_check(&f, 2500) == SENSOR_FILTER_PASS, "escalón rechazado tras max_rejects");
+
+    printf("%-32s %s\n", "comprobación sin estado", failures == before ? "ok" : "FALLO");
+}
+
+static void test_paired(void)
+{
+    // Temperatura y humedad de una misma lectura, como en leer_sensor_filtrado()
+    sensor_filter_t temp, hum;
+    sensor_fixed_t t_out, h_out;
+    int before = failures;
+
+    sensor_filter_init(&temp);
+    sensor_filter_add_rate(&temp, 500, 3);
+    sensor_filter_add_median(&temp, 3);
+    sensor_filter_init(&hum);
+    sensor_filter_add_rate(&hum, 1000, 3);
+    sensor_filter_add_median(&hum, 3);
+
+    sensor_filter_process(&temp, 2000, &t_out);
+    sensor_filter_process(&hum, 5000, &h_out);
+
+    // La humedad salta: la lectura entera se descarta y la temperatura no llega a procesarse
+    for (int i = 0; i < 2; i++)
+    {
+        bool ok_t = sensor_filter_check(&temp, 2400) == SENSOR_FILTER_PASS;
+        bool ok_h = sensor_filter_check(&hum, 9000) == SENSOR_FILTER_PASS;
+        CHECK(ok_t && !ok_h, "lectura %d: temperatura %d, humedad %d", i, ok_t, ok_h);
+        if (!ok_h) sensor_filter_process(&hum, 9000, &h_out);
+    }
+
+    // Con la mediana intacta, la siguiente temperatura válida sale tal cual (media de 2000 y 2100)
+    sensor_filter_process(&temp, 2100, &t_out);
+    CHECK(t_out == 2050, "temperatura %ld, esperada 2050", (long)t_out);
+
+    printf("%-32s %s\n", "filtros emparejados", failures == before ? "ok" : "FALLO");
+}
+
+int main(void)
+{
+    test_range();
+    test_median();
+    test_ema();
+    test_rate();
+    test_hysteresis();
+    test_check();
+    test_paired();
+
+    printf("%s\n", failures ? "Comprobaciones con fallos" : "Todas las comprobaciones correctas");
+    return failures ? 1 : 0;
+}
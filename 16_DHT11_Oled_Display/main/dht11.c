@@ -27,18 +27,9 @@ void hold_low(dht11_t dht11,int hold_time_us)
 int dht11_read(dht11_t *dht11,int connection_timeout)
 {
     int waited = 0;
-    int one_duration = 0;
-    int zero_duration = 0;
     int timeout_counter = 0;
-
-    uint8_t received_data[5] =
-    {
-        0x00,
-        0x00,
-        0x00,
-        0x00,
-        0x00
-    };
+    dht_pulse_t pulses[DHT_DECODE_BITS];
+    dht_reading_t reading;
 
     while(timeout_counter < connection_timeout)
     {
@@ -77,24 +68,23 @@ int dht11_read(dht11_t *dht11,int connection_timeout)
     
     if(timeout_counter == connection_timeout) return -1;
 
-    for(int i = 0; i < 5; i++)
+    // wait_for_state() returns -1 on timeout, which the decoder rejects as a missing edge
+    for(int i = 0; i < DHT_DECODE_BITS; i++)
     {
-        for(int j = 0; j < 8; j++)
-        {
-            zero_duration = wait_for_state(*dht11,1,58);
-            one_duration = wait_for_state(*dht11,0,74);
-            received_data[i] |= (one_duration > zero_duration) << (7 - j);
-        }
-    }
-    int crc = received_data[0]+received_data[1]+received_data[2]+received_data[3];
-    crc = crc & 0xff;
-    if(crc == received_data[4]) {
-      dht11->humidity = received_data[0] + received_data[1] / 10.0;
-      dht11->temperature = received_data[2] + received_data[3] / 10.0;
-      return 0;
+        waited = wait_for_state(*dht11,1,58);
+        pulses[i].low_us = waited < 0 ? 0 : waited;
+        waited = wait_for_state(*dht11,0,74);
+        pulses[i].high_us = waited < 0 ? 0 : waited;
     }
-    else {
-        ESP_LOGE("DHT11:", "Wrong checksum");
+
+    dht_decode_status_t status = dht_decode(pulses, DHT_DECODE_BITS, DHT_TYPE_DHT11, &reading);
+    if(status != DHT_DECODE_OK)
+    {
+        ESP_LOGE("DHT11:", "%s", dht_decode_status_str(status));
         return -1;
     }
-}
\ No newline at end of file
+
+    dht11->humidity = reading.humidity;
+    dht11->temperature = reading.temperature;
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <rom/ets_sys.h>
 #include "esp_log.h"
+#include "dht_decode.h"
 
 /**
  * Structure containing readings and info about the dht11
@@ -0,0 +1,138 @@
+#include "dht_async.h"
+#include "esp_log.h"
+
+static const char *TAG = "DHT_ASYNC";
+
+static void IRAM_ATTR dht_async_edge_isr(void *arg)
+{
+    dht_async_t *dht = (dht_async_t *)arg;
+    uint8_t n = dht->edge_count;
+
+    if (n >= DHT_ASYNC_MAX_EDGES) return;
+
+    dht->edge_time[n] = esp_timer_get_time();
+    dht->edge_level[n] = gpio_get_level(dht->pin);
+    dht->edge_count = n + 1;
+}
+
+static void dht_async_finish(dht_async_t *dht)
+{
+    dht_pulse_t pulses[DHT_ASYNC_MAX_EDGES / 2];
+    dht_reading_t reading;
+    esp_err_t result = ESP_OK;
+
+    gpio_intr_disable(dht->pin);
+    size_t edges = dht->edge_count;
+    dht->state = DHT_ASYNC_IDLE;
+
+    if (edges == 0)
+    {
+        ESP_LOGE(TAG, "No response from sensor");
+        result = ESP_ERR_TIMEOUT;
+    }
+    else
+    {
+        size_t count = dht_edges_to_pulses(dht->edge_time, dht->edge_level, edges, pulses);
+        dht_decode_status_t status = dht_decode(pulses, count, DHT_TYPE_DHT11, &reading);
+        if (status != DHT_DECODE_OK)
+        {
+            ESP_LOGE(TAG, "Decode failed: %s (%u edges)", dht_decode_status_str(status), (unsigned)edges);
+            result = status == DHT_DECODE_CHECKSUM ? ESP_ERR_INVALID_CRC : ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    if (dht->callback) dht->callback(result, result == ESP_OK ? &reading : NULL, dht->callback_arg);
+}
+
+static void dht_async_timer_cb(void *arg)
+{
+    dht_async_t *dht = (dht_async_t *)arg;
+
+    if (dht->state == DHT_ASYNC_START)
+    {
+        // End of the start pulse: release the line and timestamp everything the sensor sends
+        dht->edge_count = 0;
+        dht->state = DHT_ASYNC_CAPTURE;
+        gpio_set_level(dht->pin, 1);
+        gpio_intr_enable(dht->pin);
+        esp_timer_start_once(dht->timer, DHT_ASYNC_FRAME_TIMEOUT_US);
+    }
+    else if (dht->state == DHT_ASYNC_CAPTURE)
+    {
+        dht_async_finish(dht);
+    }
+}
+
+esp_err_t dht_async_init(dht_async_t *dht, gpio_num_t pin, dht_async_cb_t callback, void *arg)
+{
+    if (dht == NULL) return ESP_ERR_INVALID_ARG;
+
+    dht->pin = pin;
+    dht->callback = callback;
+    dht->callback_arg = arg;
+    dht->state = DHT_ASYNC_IDLE;
+    dht->edge_count = 0;
+
+    gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_config);
+    if (ret != ESP_OK) return ret;
+    gpio_set_level(pin, 1);
+    gpio_intr_disable(pin);
+
+    // The ISR service may already be installed by another driver
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return ret;
+
+    ret = gpio_isr_handler_add(pin, dht_async_edge_isr, dht);
+    if (ret != ESP_OK) return ret;
+
+    esp_timer_create_args_t timer_args = {
+        .callback = dht_async_timer_cb,
+        .arg = dht,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "dht_async",
+    };
+    ret = esp_timer_create(&timer_args, &dht->timer);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create timer: %s", esp_err_to_name(ret));
+        gpio_isr_handler_remove(pin);
+    }
+    return ret;
+}
+
+esp_err_t dht_async_start(dht_async_t *dht)
+{
+    if (dht->state != DHT_ASYNC_IDLE) return ESP_ERR_INVALID_STATE;
+
+    dht->state = DHT_ASYNC_START;
+    gpio_set_level(dht->pin, 0);
+
+    esp_err_t ret = esp_timer_start_once(dht->timer, DHT_ASYNC_START_LOW_US);
+    if (ret != ESP_OK)
+    {
+        gpio_set_level(dht->pin, 1);
+        dht->state = DHT_ASYNC_IDLE;
+    }
+    return ret;
+}
+
+esp_err_t dht_async_deinit(dht_async_t *dht)
+{
+    gpio_intr_disable(dht->pin);
+    gpio_isr_handler_remove(dht->pin);
+    if (dht->timer)
+    {
+        esp_timer_stop(dht->timer);
+        esp_timer_delete(dht->timer);
+        dht->timer = NULL;
+    }
+    dht->state = DHT_ASYNC_IDLE;
+    return ESP_OK;
+}
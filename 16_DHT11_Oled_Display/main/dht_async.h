@@ -0,0 +1,79 @@
+#ifndef DHT_ASYNC
+#define DHT_ASYNC
+
+#include <driver/gpio.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "dht_decode.h"
+
+// Time the host holds the line low to wake the sensor (>= 18 ms for the DHT11)
+#define DHT_ASYNC_START_LOW_US 20000
+
+// Capture window after the line is released; a full frame takes less than 5 ms
+#define DHT_ASYNC_FRAME_TIMEOUT_US 8000
+
+// Response (2 edges) + 40 bits (2 edges each) + end of frame (2 edges), with margin for glitches
+#define DHT_ASYNC_MAX_EDGES 96
+
+/**
+ * @brief Called when a read started with dht_async_start() finishes
+ * @note  Runs in the esp_timer task: keep it short (copy the reading, notify a task)
+ * @param result ESP_OK, ESP_ERR_TIMEOUT, ESP_ERR_INVALID_RESPONSE or ESP_ERR_INVALID_CRC
+ * @param reading decoded values, valid only when result is ESP_OK
+ * @param arg user argument given to dht_async_init()
+*/
+typedef void (*dht_async_cb_t)(esp_err_t result, const dht_reading_t *reading, void *arg);
+
+typedef enum
+{
+    DHT_ASYNC_IDLE,
+    DHT_ASYNC_START,    // Start pulse in progress, line held low
+    DHT_ASYNC_CAPTURE,  // Line released, edges are being timestamped
+} dht_async_state_t;
+
+/**
+ * Non-blocking DHT reader driven by a timer and a GPIO edge interrupt
+ * @var pin GPIO the sensor data line is connected to
+ * @var timer one-shot timer ending the start pulse and then the capture window
+ * @var callback completion callback
+ * @var callback_arg user argument for the callback
+ * @var state current phase of the read
+ * @var edge_count number of edges captured by the ISR
+ * @var edge_time esp_timer timestamp of each edge in microseconds
+ * @var edge_level line level right after each edge
+*/
+typedef struct
+{
+    gpio_num_t pin;
+    esp_timer_handle_t timer;
+    dht_async_cb_t callback;
+    void *callback_arg;
+    volatile dht_async_state_t state;
+    volatile uint8_t edge_count;
+    int64_t edge_time[DHT_ASYNC_MAX_EDGES];
+    uint8_t edge_level[DHT_ASYNC_MAX_EDGES];
+} dht_async_t;
+
+/**
+ * @brief Configures the pin as open drain, installs the edge ISR and creates the timer
+ * @param dht reader to initialize
+ * @param pin GPIO the sensor data line is connected to (external pull-up required)
+ * @param callback called with the result of every read
+ * @param arg user argument passed to the callback
+*/
+esp_err_t dht_async_init(dht_async_t *dht, gpio_num_t pin, dht_async_cb_t callback, void *arg);
+
+/**
+ * @brief Starts a read and returns immediately
+ * @note  The start pulse is timed by esp_timer and the frame is captured in the GPIO ISR,
+ *        so the calling task is free until the callback runs about 28 ms later
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if a read is already in flight
+*/
+esp_err_t dht_async_start(dht_async_t *dht);
+
+/**
+ * @brief Removes the ISR handler and deletes the timer
+*/
+esp_err_t dht_async_deinit(dht_async_t *dht);
+
+#endif
@@ -0,0 +1,67 @@
+#include "dht_decode.h"
+
+dht_decode_status_t dht_decode(const dht_pulse_t *pulses, size_t count, dht_sensor_type_t type, dht_reading_t *reading)
+{
+    if (count < DHT_DECODE_BITS) return DHT_DECODE_INCOMPLETE;
+
+    const dht_pulse_t *bits = pulses + count - DHT_DECODE_BITS;
+
+    for (int i = 0; i < 5; i++) reading->raw[i] = 0;
+
+    for (int i = 0; i < DHT_DECODE_BITS; i++)
+    {
+        uint16_t low = bits[i].low_us;
+        uint16_t high = bits[i].high_us;
+
+        if (low == 0 || high == 0 || low > DHT_DECODE_MAX_PULSE_US || high > DHT_DECODE_MAX_PULSE_US)
+            return DHT_DECODE_BAD_PULSE;
+
+        // Comparing against the low part of the same cell tolerates a scaled time base
+        reading->raw[i / 8] = (reading->raw[i / 8] << 1) | (high > low);
+    }
+
+    const uint8_t *raw = reading->raw;
+    if (((raw[0] + raw[1] + raw[2] + raw[3]) & 0xff) != raw[4]) return DHT_DECODE_CHECKSUM;
+
+    if (type == DHT_TYPE_DHT22)
+    {
+        reading->humidity = ((raw[0] << 8) | raw[1]) / 10.0f;
+        reading->temperature = (((raw[2] & 0x7f) << 8) | raw[3]) / 10.0f;
+        if (raw[2] & 0x80) reading->temperature = -reading->temperature;
+    }
+    else
+    {
+        reading->humidity = raw[0] + raw[1] / 10.0f;
+        reading->temperature = raw[2] + raw[3] / 10.0f;
+    }
+    return DHT_DECODE_OK;
+}
+
+size_t dht_edges_to_pulses(const int64_t *time, const uint8_t *level, size_t edges, dht_pulse_t *pulses)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i + 2 < edges; i++)
+    {
+        if (level[i] != 0 || level[i + 1] != 1 || level[i + 2] != 0) continue;
+
+        int64_t low = time[i + 1] - time[i];
+        int64_t high = time[i + 2] - time[i + 1];
+        pulses[count].low_us = low > UINT16_MAX ? UINT16_MAX : low;
+        pulses[count].high_us = high > UINT16_MAX ? UINT16_MAX : high;
+        count++;
+    }
+    return count;
+}
+
+const char *dht_decode_status_str(dht_decode_status_t status)
+{
+    switch (status)
+    {
+    case DHT_DECODE_OK: return "ok";
+    case DHT_DECODE_INCOMPLETE: return "incomplete frame";
+    case DHT_DECODE_BAD_PULSE: return "bad pulse";
+    case DHT_DECODE_CHECKSUM: return "wrong checksum";
+    }
+    return "unknown";
+}
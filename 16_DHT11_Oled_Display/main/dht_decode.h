@@ -0,0 +1,82 @@
+#ifndef DHT_DECODE
+#define DHT_DECODE
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of data bits in a DHT frame (humidity, temperature, checksum)
+#define DHT_DECODE_BITS 40
+
+// Pulses longer than this are not part of a DHT frame (longest one is the 80 us response)
+#define DHT_DECODE_MAX_PULSE_US 200
+
+/**
+ * One bit cell as seen on the data line: the sensor pulls the line low and then releases it.
+ * The length of the high part relative to the low part encodes the bit
+ * (50 us low + 26-28 us high = 0, 50 us low + 70 us high = 1).
+ * @var low_us duration of the low part in microseconds
+ * @var high_us duration of the high part in microseconds
+*/
+typedef struct
+{
+    uint16_t low_us;
+    uint16_t high_us;
+} dht_pulse_t;
+
+typedef enum
+{
+    DHT_TYPE_DHT11,             // 1 % / 1 C resolution, integral and decimal bytes
+    DHT_TYPE_DHT22,             // DHT22/AM2302: 16-bit values in tenths, temperature sign in bit 15
+} dht_sensor_type_t;
+
+typedef enum
+{
+    DHT_DECODE_OK = 0,
+    DHT_DECODE_INCOMPLETE,      // Fewer than 40 bit cells captured
+    DHT_DECODE_BAD_PULSE,       // A bit cell is missing an edge or is out of range
+    DHT_DECODE_CHECKSUM,        // Frame decoded but the checksum does not match
+} dht_decode_status_t;
+
+/**
+ * Decoded frame
+ * @var raw the 5 bytes of the frame (checksum last)
+ * @var humidity relative humidity in %
+ * @var temperature temperature in degrees Celsius
+*/
+typedef struct
+{
+    uint8_t raw[5];
+    float humidity;
+    float temperature;
+} dht_reading_t;
+
+/**
+ * @brief Decodes a DHT11 or DHT22 frame from captured pulse widths
+ * @note  Pure function with no hardware access: any capture backend (polling, RMT, edge
+ *        interrupts) converts what it measured into bit cells and feeds them here.
+ * @note  The frame is anchored at the end of the capture: the last 40 cells are the data bits,
+ *        so leading cells (line release, sensor response, glitches) are ignored.
+ * @param pulses captured bit cells in the order they were received
+ * @param count number of cells in pulses
+ * @param type sensor model, selects how the bytes are converted
+ * @param reading filled with the raw bytes; humidity and temperature only on DHT_DECODE_OK
+*/
+dht_decode_status_t dht_decode(const dht_pulse_t *pulses, size_t count, dht_sensor_type_t type, dht_reading_t *reading);
+
+/**
+ * @brief Builds bit cells from timestamped edges (falling, rising, next falling edge)
+ * @note  Used by the edge interrupt backends; edges not matching the pattern are skipped
+ * @param time timestamp of each edge in microseconds
+ * @param level line level right after each edge
+ * @param edges number of edges
+ * @param pulses output, room for at least edges / 2 cells
+ * @return number of cells written
+*/
+size_t dht_edges_to_pulses(const int64_t *time, const uint8_t *level, size_t edges, dht_pulse_t *pulses);
+
+/**
+ * @brief Returns a printable name for a decode status
+*/
+const char *dht_decode_status_str(dht_decode_status_t status);
+
+#endif
@@ -0,0 +1,176 @@
+#include "dht_multi.h"
+#include "esp_log.h"
+
+static const char *TAG = "DHT_MULTI";
+
+static void IRAM_ATTR dht_multi_edge_isr(void *arg)
+{
+    dht_multi_channel_t *channel = (dht_multi_channel_t *)arg;
+    uint8_t n = channel->edge_count;
+
+    if (n >= DHT_MULTI_MAX_EDGES) return;
+
+    channel->edge_time[n] = esp_timer_get_time();
+    channel->edge_level[n] = gpio_get_level(channel->pin);
+    channel->edge_count = n + 1;
+}
+
+static void dht_multi_finish(dht_multi_t *group)
+{
+    dht_pulse_t pulses[DHT_MULTI_MAX_EDGES / 2];
+
+    for (size_t i = 0; i < group->count; i++) gpio_intr_disable(group->sensors[i].pin);
+
+    for (size_t i = 0; i < group->count; i++)
+    {
+        dht_multi_channel_t *channel = &group->channels[i];
+        dht_multi_reading_t *out = &group->readings[i];
+
+        out->pin = group->sensors[i].pin;
+        if (channel->edge_count == 0)
+        {
+            out->result = ESP_ERR_TIMEOUT;
+            continue;
+        }
+
+        size_t count = dht_edges_to_pulses(channel->edge_time, channel->edge_level, channel->edge_count, pulses);
+        dht_decode_status_t status = dht_decode(pulses, count, group->sensors[i].type, &out->reading);
+        if (status == DHT_DECODE_OK)
+        {
+            out->result = ESP_OK;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "GPIO %d: %s", out->pin, dht_decode_status_str(status));
+            out->result = status == DHT_DECODE_CHECKSUM ? ESP_ERR_INVALID_CRC : ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    group->state = DHT_MULTI_IDLE;
+    if (group->callback) group->callback(group->readings, group->count, group->callback_arg);
+}
+
+static void dht_multi_timer_cb(void *arg)
+{
+    dht_multi_t *group = (dht_multi_t *)arg;
+
+    if (group->state == DHT_MULTI_START)
+    {
+        for (size_t i = 0; i < group->count; i++) group->channels[i].edge_count = 0;
+        group->state = DHT_MULTI_CAPTURE;
+
+        // Release every line back to back so the sensors answer within a few microseconds
+        for (size_t i = 0; i < group->count; i++) gpio_set_level(group->sensors[i].pin, 1);
+        for (size_t i = 0; i < group->count; i++) gpio_intr_enable(group->sensors[i].pin);
+
+        esp_timer_start_once(group->timer, DHT_MULTI_FRAME_TIMEOUT_US);
+    }
+    else if (group->state == DHT_MULTI_CAPTURE)
+    {
+        dht_multi_finish(group);
+    }
+}
+
+esp_err_t dht_multi_init(dht_multi_t *group, const dht_multi_sensor_t *sensors, size_t count,
+                         dht_multi_cb_t callback, void *arg)
+{
+    if (group == NULL || sensors == NULL || count == 0 || count > DHT_MULTI_MAX_SENSORS)
+        return ESP_ERR_INVALID_ARG;
+
+    group->count = 0;
+    group->timer = NULL;
+    group->state = DHT_MULTI_IDLE;
+    group->callback = callback;
+    group->callback_arg = arg;
+    group->start_low_us = DHT_MULTI_START_LOW_DHT22_US;
+
+    uint64_t pin_mask = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        pin_mask |= 1ULL << sensors[i].pin;
+        if (sensors[i].type == DHT_TYPE_DHT11) group->start_low_us = DHT_MULTI_START_LOW_DHT11_US;
+    }
+
+    gpio_config_t io_config = {
+        .pin_bit_mask = pin_mask,
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_config);
+    if (ret != ESP_OK) return ret;
+
+    // The ISR service may already be installed by another driver
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return ret;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dht_multi_channel_t *channel = &group->channels[i];
+
+        group->sensors[i] = sensors[i];
+        channel->group = group;
+        channel->pin = sensors[i].pin;
+        channel->edge_count = 0;
+
+        gpio_set_level(sensors[i].pin, 1);
+        gpio_intr_disable(sensors[i].pin);
+        ret = gpio_isr_handler_add(sensors[i].pin, dht_multi_edge_isr, channel);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to add ISR for GPIO %d: %s", sensors[i].pin, esp_err_to_name(ret));
+            dht_multi_deinit(group);
+            return ret;
+        }
+        group->count = i + 1;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = dht_multi_timer_cb,
+        .arg = group,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "dht_multi",
+    };
+    ret = esp_timer_create(&timer_args, &group->timer);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create timer: %s", esp_err_to_name(ret));
+        dht_multi_deinit(group);
+    }
+    return ret;
+}
+
+esp_err_t dht_multi_start(dht_multi_t *group)
+{
+    if (group->state != DHT_MULTI_IDLE) return ESP_ERR_INVALID_STATE;
+
+    group->state = DHT_MULTI_START;
+    for (size_t i = 0; i < group->count; i++) gpio_set_level(group->sensors[i].pin, 0);
+
+    esp_err_t ret = esp_timer_start_once(group->timer, group->start_low_us);
+    if (ret != ESP_OK)
+    {
+        for (size_t i = 0; i < group->count; i++) gpio_set_level(group->sensors[i].pin, 1);
+        group->state = DHT_MULTI_IDLE;
+    }
+    return ret;
+}
+
+esp_err_t dht_multi_deinit(dht_multi_t *group)
+{
+    if (group->timer)
+    {
+        esp_timer_stop(group->timer);
+        esp_timer_delete(group->timer);
+        group->timer = NULL;
+    }
+    for (size_t i = 0; i < group->count; i++)
+    {
+        gpio_intr_disable(group->sensors[i].pin);
+        gpio_isr_handler_remove(group->sensors[i].pin);
+    }
+    group->count = 0;
+    group->state = DHT_MULTI_IDLE;
+    return ESP_OK;
+}
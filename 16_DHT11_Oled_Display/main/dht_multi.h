@@ -0,0 +1,119 @@
+#ifndef DHT_MULTI
+#define DHT_MULTI
+
+#include <driver/gpio.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "dht_decode.h"
+
+// Maximum number of sensors in one group
+#define DHT_MULTI_MAX_SENSORS 8
+
+// Start pulse: >= 18 ms for the DHT11, 0.8-20 ms for the DHT22/AM2302
+#define DHT_MULTI_START_LOW_DHT11_US 19000
+#define DHT_MULTI_START_LOW_DHT22_US 1100
+
+// Capture window after the lines are released; a full frame takes less than 5 ms
+#define DHT_MULTI_FRAME_TIMEOUT_US 8000
+
+// Edges kept per sensor: response (2) + 40 bits (2 each) + end of frame (2), plus margin
+#define DHT_MULTI_MAX_EDGES 88
+
+/**
+ * One sensor of the group
+ * @var pin GPIO the data line is connected to (external pull-up required)
+ * @var type sensor model
+*/
+typedef struct
+{
+    gpio_num_t pin;
+    dht_sensor_type_t type;
+} dht_multi_sensor_t;
+
+/**
+ * Result for one sensor of a batch
+ * @var pin GPIO of the sensor
+ * @var result ESP_OK, ESP_ERR_TIMEOUT, ESP_ERR_INVALID_RESPONSE or ESP_ERR_INVALID_CRC
+ * @var reading decoded values, valid only when result is ESP_OK
+*/
+typedef struct
+{
+    gpio_num_t pin;
+    esp_err_t result;
+    dht_reading_t reading;
+} dht_multi_reading_t;
+
+/**
+ * @brief Called once per cycle with the readings of every sensor, in the order of the configuration
+ * @note  Runs in the esp_timer task: keep it short
+*/
+typedef void (*dht_multi_cb_t)(const dht_multi_reading_t *readings, size_t count, void *arg);
+
+struct dht_multi;
+
+/**
+ * Edge capture of one sensor, written by its GPIO ISR
+*/
+typedef struct
+{
+    struct dht_multi *group;
+    gpio_num_t pin;
+    volatile uint8_t edge_count;
+    int64_t edge_time[DHT_MULTI_MAX_EDGES];
+    uint8_t edge_level[DHT_MULTI_MAX_EDGES];
+} dht_multi_channel_t;
+
+typedef enum
+{
+    DHT_MULTI_IDLE,
+    DHT_MULTI_START,
+    DHT_MULTI_CAPTURE,
+} dht_multi_state_t;
+
+/**
+ * Group of DHT sensors read concurrently: one shared start pulse and one capture window
+ * for all of them, so a cycle takes as long as a single read whatever the number of sensors.
+ * @var count number of sensors
+ * @var sensors configuration of each sensor
+ * @var channels edge capture of each sensor
+ * @var readings results of the last cycle
+ * @var start_low_us start pulse length, the longest one required by the sensors of the group
+ * @var timer one-shot timer ending the start pulse and then the capture window
+ * @var state current phase of the cycle
+*/
+typedef struct dht_multi
+{
+    size_t count;
+    dht_multi_sensor_t sensors[DHT_MULTI_MAX_SENSORS];
+    dht_multi_channel_t channels[DHT_MULTI_MAX_SENSORS];
+    dht_multi_reading_t readings[DHT_MULTI_MAX_SENSORS];
+    uint32_t start_low_us;
+    esp_timer_handle_t timer;
+    volatile dht_multi_state_t state;
+    dht_multi_cb_t callback;
+    void *callback_arg;
+} dht_multi_t;
+
+/**
+ * @brief Configures the pins as open drain with an edge ISR each and creates the timer
+ * @param group group to initialize (about 1 KB per sensor, allocate statically)
+ * @param sensors pins and models of the sensors, copied into the group
+ * @param count number of sensors (1 to DHT_MULTI_MAX_SENSORS)
+ * @param callback called with the batch of readings at the end of every cycle
+ * @param arg user argument passed to the callback
+*/
+esp_err_t dht_multi_init(dht_multi_t *group, const dht_multi_sensor_t *sensors, size_t count,
+                         dht_multi_cb_t callback, void *arg);
+
+/**
+ * @brief Starts a cycle: all lines go low together and are released together
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if a cycle is already in flight
+*/
+esp_err_t dht_multi_start(dht_multi_t *group);
+
+/**
+ * @brief Removes the ISR handlers and deletes the timer
+*/
+esp_err_t dht_multi_deinit(dht_multi_t *group);
+
+#endif
@@ -0,0 +1,151 @@
+#include "dht_rmt.h"
+#include "esp_log.h"
+
+static const char *TAG = "DHT_RMT";
+
+// Pulses shorter than this are filtered out as glitches (hardware limit ~3 us)
+#define DHT_RMT_MIN_PULSE_NS 1000
+
+// A level held longer than this ends the frame (longest DHT pulse is 80 us)
+#define DHT_RMT_IDLE_NS 200000
+
+static bool IRAM_ATTR dht_rmt_rx_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data)
+{
+    BaseType_t high_task_wakeup = pdFALSE;
+    QueueHandle_t queue = (QueueHandle_t)user_data;
+
+    xQueueSendFromISR(queue, edata, &high_task_wakeup);
+    return high_task_wakeup == pdTRUE;
+}
+
+// Turns the RMT symbols into bit cells: every low level followed by a high level is one cell
+static size_t dht_rmt_to_pulses(const rmt_symbol_word_t *symbols, size_t num_symbols, dht_pulse_t *pulses, size_t max_pulses)
+{
+    size_t count = 0;
+    uint16_t pending_low = 0;
+
+    for (size_t i = 0; i < num_symbols; i++)
+    {
+        const uint16_t durations[2] = {symbols[i].duration0, symbols[i].duration1};
+        const uint16_t levels[2] = {symbols[i].level0, symbols[i].level1};
+        for (int j = 0; j < 2; j++)
+        {
+            if (durations[j] == 0) continue;
+            if (levels[j] == 0)
+            {
+                pending_low = durations[j];
+            }
+            else if (pending_low && count < max_pulses)
+            {
+                pulses[count].low_us = pending_low;
+                pulses[count].high_us = durations[j];
+                count++;
+                pending_low = 0;
+            }
+        }
+    }
+    return count;
+}
+
+esp_err_t dht_rmt_init(dht_rmt_t *dht, gpio_num_t pin)
+{
+    if (dht == NULL) return ESP_ERR_INVALID_ARG;
+
+    dht->pin = pin;
+    dht->done_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    if (dht->done_queue == NULL) return ESP_ERR_NO_MEM;
+
+    rmt_rx_channel_config_t rx_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_SYMBOLS,
+        .gpio_num = pin,
+    };
+    esp_err_t ret = rmt_new_rx_channel(&rx_config, &dht->channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create RMT RX channel: %s", esp_err_to_name(ret));
+        vQueueDelete(dht->done_queue);
+        return ret;
+    }
+
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = dht_rmt_rx_done,
+    };
+    ret = rmt_rx_register_event_callbacks(dht->channel, &callbacks, dht->done_queue);
+    if (ret == ESP_OK) ret = rmt_enable(dht->channel);
+
+    // The RMT only reads the pin; the start pulse is driven through the GPIO as open drain
+    if (ret == ESP_OK) ret = gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    if (ret == ESP_OK) ret = gpio_set_level(pin, 1);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to configure RMT RX channel: %s", esp_err_to_name(ret));
+        dht_rmt_deinit(dht);
+    }
+    return ret;
+}
+
+esp_err_t dht_rmt_read(dht_rmt_t *dht, dht11_t *reading)
+{
+    rmt_rx_done_event_data_t rx_data;
+    dht_pulse_t pulses[DHT_RMT_SYMBOLS];
+    dht_reading_t decoded;
+
+    rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = DHT_RMT_MIN_PULSE_NS,
+        .signal_range_max_ns = DHT_RMT_IDLE_NS,
+    };
+
+    // Start pulse: the task sleeps while the line is held low
+    gpio_set_level(dht->pin, 0);
+    vTaskDelay(pdMS_TO_TICKS(DHT_RMT_START_LOW_MS) + 1);
+
+    // Arm the receiver before releasing the line so the response is not missed
+    xQueueReset(dht->done_queue);
+    esp_err_t ret = rmt_receive(dht->channel, dht->symbols, sizeof(dht->symbols), &receive_config);
+    gpio_set_level(dht->pin, 1);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to start RMT receive: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (xQueueReceive(dht->done_queue, &rx_data, pdMS_TO_TICKS(DHT_RMT_FRAME_TIMEOUT_MS) + 1) != pdTRUE)
+    {
+        // No idle period seen: the sensor never answered. Disabling the channel aborts the receive
+        rmt_disable(dht->channel);
+        rmt_enable(dht->channel);
+        ESP_LOGE(TAG, "No response from sensor");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    size_t count = dht_rmt_to_pulses(rx_data.received_symbols, rx_data.num_symbols, pulses, DHT_RMT_SYMBOLS);
+    dht_decode_status_t status = dht_decode(pulses, count, DHT_TYPE_DHT11, &decoded);
+    if (status != DHT_DECODE_OK)
+    {
+        ESP_LOGE(TAG, "Decode failed: %s (%u cells)", dht_decode_status_str(status), (unsigned)count);
+        return status == DHT_DECODE_CHECKSUM ? ESP_ERR_INVALID_CRC : ESP_ERR_INVALID_RESPONSE;
+    }
+
+    reading->humidity = decoded.humidity;
+    reading->temperature = decoded.temperature;
+    return ESP_OK;
+}
+
+esp_err_t dht_rmt_deinit(dht_rmt_t *dht)
+{
+    if (dht->channel)
+    {
+        rmt_disable(dht->channel);
+        rmt_del_channel(dht->channel);
+        dht->channel = NULL;
+    }
+    if (dht->done_queue)
+    {
+        vQueueDelete(dht->done_queue);
+        dht->done_queue = NULL;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,65 @@
+#ifndef DHT_RMT
+#define DHT_RMT
+
+#include <driver/gpio.h>
+#include <driver/rmt_rx.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "dht11.h"
+#include "dht_decode.h"
+
+// RMT tick resolution: 1 tick = 1 us
+#define DHT_RMT_RESOLUTION_HZ 1000000
+
+// Response (2 pulses) + 40 bits (2 pulses each) + end pulse, 2 pulses per RMT symbol
+#define DHT_RMT_SYMBOLS 64
+
+// Time the host holds the line low to wake the sensor (>= 18 ms for the DHT11)
+#define DHT_RMT_START_LOW_MS 20
+
+// Maximum time to wait for the whole frame once the line is released
+#define DHT_RMT_FRAME_TIMEOUT_MS 10
+
+/**
+ * DHT reader based on the RMT receive peripheral
+ * @var pin GPIO the sensor data line is connected to
+ * @var channel RMT RX channel capturing the pulse widths
+ * @var done_queue receives the RMT "receive done" event from the ISR
+ * @var symbols buffer the RMT writes the captured pulses to, decoded with dht_decode()
+*/
+typedef struct
+{
+    gpio_num_t pin;
+    rmt_channel_handle_t channel;
+    QueueHandle_t done_queue;
+    rmt_symbol_word_t symbols[DHT_RMT_SYMBOLS];
+} dht_rmt_t;
+
+/**
+ * @brief Creates the RMT RX channel and configures the pin as open drain
+ * @param dht reader to initialize
+ * @param pin GPIO the sensor data line is connected to (external pull-up required)
+*/
+esp_err_t dht_rmt_init(dht_rmt_t *dht, gpio_num_t pin);
+
+/**
+ * @brief Reads temperature and humidity from the sensor
+ * @note  The task sleeps during the start pulse and while the RMT captures the frame,
+ *        so the CPU is free for the ~25 ms the transaction lasts. Pulses are decoded
+ *        afterwards, so interrupts during the transfer cannot corrupt the reading.
+ * @note  Wait for at least 1 second (DHT11) between reads
+ * @param dht initialized reader
+ * @param reading updated with the new temperature and humidity on success
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the sensor did not answer, ESP_ERR_INVALID_RESPONSE if the
+ *         frame could not be decoded or ESP_ERR_INVALID_CRC if the checksum did not match
+*/
+esp_err_t dht_rmt_read(dht_rmt_t *dht, dht11_t *reading);
+
+/**
+ * @brief Releases the RMT channel and the event queue
+*/
+esp_err_t dht_rmt_deinit(dht_rmt_t *dht);
+
+#endif
@@ -22,6 +22,11 @@
 #include "freertos/FreeRTOS.h"  // Definiciones principales de FreeRTOS
 #include "freertos/task.h"      // Funciones de tareas de FreeRTOS
 #include "dht11.h"              // Controlador del sensor DHT11
+#include "dht_rmt.h"            // Lectura del DHT11 con el periférico RMT
+#include "dht_async.h"          // Lectura del DHT11 por interrupciones, sin bloquear
+#include "sensor_cache.h"       // Caché de muestras compartida entre tareas
+#include "sensor_filter.h"      // Filtros en punto fijo para las lecturas
+#include "esp_cpu.h"            // Contador de ciclos para la medición de los filtros
 #include "ssd1306.h"            // Controlador de pantalla OLED SSD1306
 
 // Etiqueta para mensajes de log
@@ -29,16 +34,226 @@ static const char *TAG = "DHT11_OLED_DEMO";
 
 // Configuración de pines
 #define CONFIG_DHT11_PIN         GPIO_NUM_4  // Pin de datos del DHT11
-#define CONFIG_CONNECTION_TIMEOUT 5          // Tiempo de espera en segundos
+
+// Método de lectura: 1 = temporizador + interrupciones (dht_async), 0 = periférico RMT (dht_rmt)
+#define DHT_READER_ASYNC         1
+
+// Tiempo máximo de espera del resultado de una lectura asíncrona
+#define DHT_ASYNC_WAIT_MS        100
 
 // Tiempo entre lecturas (mínimo 2 segundos para DHT11)
 #define READ_INTERVAL_MS          2000
 
+// Intervalo mínimo entre lecturas reales del sensor y antigüedad a partir de la cual se refresca
+#define CACHE_MIN_INTERVAL_MS     1000
+#define CACHE_MAX_AGE_MS          2000
+
+// Una muestra más antigua que esto se considera perdida y se muestra el error
+#define SAMPLE_EXPIRED_MS         10000
+
+// Periodo de la tarea de telemetría, segundo consumidor de la caché
+#define TELEMETRY_INTERVAL_MS     5000
+
 // Tamaño de búfer para cadenas de texto
 #define STR_BUF_SIZE             32
 
-// Valores inválidos iniciales
-#define INVALID_TEMP_HUM         0xFF
+// Cambio mínimo que provoca redibujar la pantalla (centésimas: 0.3 C y 1 %)
+#define TEMP_HYSTERESIS          30
+#define HUM_HYSTERESIS           100
+
+// 1 = medir al arrancar los ciclos por muestra de la cadena de filtros
+#define FILTER_BENCHMARK         0
+#define FILTER_BENCHMARK_SAMPLES 1000
+
+#if DHT_READER_ASYNC
+static dht_async_t dht_reader;
+static dht_reading_t ultima_lectura;
+static TaskHandle_t tarea_lectora;
+
+/**
+ * @brief Callback de fin de lectura: guarda el resultado y despierta a la tarea lectora
+ */
+static void dht_lectura_lista(esp_err_t result, const dht_reading_t *reading, void *arg)
+{
+    if (result == ESP_OK) {
+        ultima_lectura = *reading;
+    }
+    xTaskNotify(tarea_lectora, (uint32_t)result, eSetValueWithOverwrite);
+}
+#else
+static dht_rmt_t dht_reader;
+#endif
+
+// Última muestra del sensor, compartida por la pantalla y la telemetría
+static sensor_cache_t sensor_cache;
+
+// Filtros de limpieza (una vez por lectura real) y detección de cambios para la pantalla
+static sensor_filter_t filtro_temp, filtro_hum;
+static sensor_filter_t cambio_temp, cambio_hum;
+
+/**
+ * @brief Configura la cadena de limpieza de una magnitud
+ * 
+ * Rango del sensor, rechazo de saltos bruscos (se aceptan tras 3 lecturas seguidas),
+ * mediana de 5 muestras y media móvil exponencial con alfa = 1/4.
+ */
+static void configurar_limpieza(sensor_filter_t *filtro, sensor_fixed_t min, sensor_fixed_t max,
+                                sensor_fixed_t salto_max)
+{
+    sensor_filter_init(filtro);
+    sensor_filter_add_range(filtro, min, max);
+    sensor_filter_add_rate(filtro, salto_max, 3);
+    sensor_filter_add_median(filtro, 5);
+    sensor_filter_add_ema(filtro, 2);
+}
+
+/**
+ * @brief Configura los filtros de temperatura y humedad
+ */
+static void iniciar_filtros(void)
+{
+    // Rangos de medida del DHT11: 0-50 C y 20-90 %
+    configurar_limpieza(&filtro_temp, 0, 50 * SENSOR_FIXED_SCALE, 5 * SENSOR_FIXED_SCALE);
+    configurar_limpieza(&filtro_hum, 20 * SENSOR_FIXED_SCALE, 90 * SENSOR_FIXED_SCALE, 10 * SENSOR_FIXED_SCALE);
+
+    sensor_filter_init(&cambio_temp);
+    sensor_filter_add_hysteresis(&cambio_temp, TEMP_HYSTERESIS);
+    sensor_filter_init(&cambio_hum);
+    sensor_filter_add_hysteresis(&cambio_hum, HUM_HYSTERESIS);
+}
+
+#if FILTER_BENCHMARK
+/**
+ * @brief Mide los ciclos de CPU por muestra de la cadena de limpieza
+ */
+static void medir_filtros(void)
+{
+    sensor_filter_t filtro;
+    sensor_fixed_t salida;
+
+    configurar_limpieza(&filtro, 0, 50 * SENSOR_FIXED_SCALE, 5 * SENSOR_FIXED_SCALE);
+
+    esp_cpu_cycle_count_t inicio = esp_cpu_get_cycle_count();
+    for (int i = 0; i < FILTER_BENCHMARK_SAMPLES; i++) {
+        // Señal con ruido de ±0.5 C y un valor atípico cada 50 muestras
+        sensor_fixed_t muestra = 2300 + (i * 37) % 101 - 50 + (i % 50 == 0 ? 2000 : 0);
+        sensor_filter_process(&filtro, muestra, &salida);
+    }
+    esp_cpu_cycle_count_t ciclos = esp_cpu_get_cycle_count() - inicio;
+
+    ESP_LOGI(TAG, "Filtros: %" PRIu32 " ciclos por muestra (%d muestras, %" PRIu32 " rechazadas)",
+             (uint32_t)(ciclos / FILTER_BENCHMARK_SAMPLES), FILTER_BENCHMARK_SAMPLES, filtro.rejected);
+}
+#endif
+
+/**
+ * @brief Inicializa el lector del sensor DHT11
+ */
+static esp_err_t iniciar_sensor(void)
+{
+#if DHT_READER_ASYNC
+    return dht_async_init(&dht_reader, CONFIG_DHT11_PIN, dht_lectura_lista, NULL);
+#else
+    return dht_rmt_init(&dht_reader, CONFIG_DHT11_PIN);
+#endif
+}
+
+/**
+ * @brief Lee temperatura y humedad del sensor
+ * 
+ * Solo la llama la tarea de la caché. En modo asíncrono esa tarea queda bloqueada en la
+ * notificación sin consumir CPU mientras el temporizador y la interrupción capturan la trama.
+ * 
+ * @param ctx Sin uso
+ * @param lectura Estructura donde se guardan los valores leídos
+ */
+static esp_err_t leer_sensor(void *ctx, dht_reading_t *lectura)
+{
+#if DHT_READER_ASYNC
+    uint32_t result;
+    tarea_lectora = xTaskGetCurrentTaskHandle();
+    esp_err_t ret = dht_async_start(&dht_reader);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (xTaskNotifyWait(0, 0, &result, pdMS_TO_TICKS(DHT_ASYNC_WAIT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if ((esp_err_t)result == ESP_OK) {
+        *lectura = ultima_lectura;
+    }
+    return (esp_err_t)result;
+#else
+    dht11_t sensor = { .dht11_pin = CONFIG_DHT11_PIN };
+    esp_err_t ret = dht_rmt_read(&dht_reader, &sensor);
+    if (ret == ESP_OK) {
+        lectura->temperature = sensor.temperature;
+        lectura->humidity = sensor.humidity;
+    }
+    return ret;
+#endif
+}
+
+/**
+ * @brief Lee el sensor y pasa la muestra por la cadena de limpieza
+ * 
+ * Es la función de lectura de la caché, así cada muestra real se filtra una sola vez
+ * y todos los consumidores reciben los valores filtrados. Una muestra rechazada cuenta
+ * como lectura fallida y la caché conserva la anterior.
+ */
+static esp_err_t leer_sensor_filtrado(void *ctx, dht_reading_t *lectura)
+{
+    sensor_fixed_t temp, hum;
+
+    esp_err_t ret = leer_sensor(ctx, lectura);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    sensor_fixed_t in_temp = SENSOR_FIXED_FROM_FLOAT(lectura->temperature);
+    sensor_fixed_t in_hum = SENSOR_FIXED_FROM_FLOAT(lectura->humidity);
+    
+    // La muestra se acepta o se descarta entera: primero se comprueban los dos valores y solo
+    // si ambos pasan entran en la mediana y la media de su filtro
+    bool ok_temp = sensor_filter_check(&filtro_temp, in_temp) == SENSOR_FILTER_PASS;
+    bool ok_hum = sensor_filter_check(&filtro_hum, in_hum) == SENSOR_FILTER_PASS;
+    if (!ok_temp || !ok_hum) {
+        // Solo el filtro que la rechaza la procesa, así cuenta el rechazo para aceptar un escalón real
+        if (!ok_temp) {
+            sensor_filter_process(&filtro_temp, in_temp, &temp);
+        }
+        if (!ok_hum) {
+            sensor_filter_process(&filtro_hum, in_hum, &hum);
+        }
+        ESP_LOGW(TAG, "Muestra descartada: %.1f C, %.1f %%", lectura->temperature, lectura->humidity);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    
+    sensor_filter_process(&filtro_temp, in_temp, &temp);
+    sensor_filter_process(&filtro_hum, in_hum, &hum);
+
+    lectura->temperature = SENSOR_FIXED_TO_FLOAT(temp);
+    lectura->humidity = SENSOR_FIXED_TO_FLOAT(hum);
+    return ESP_OK;
+}
+
+/**
+ * @brief Tarea de telemetría: otro consumidor de la caché que nunca espera al sensor
+ */
+static void tarea_telemetria(void *arg)
+{
+    dht_reading_t lectura;
+    uint32_t edad_ms;
+
+    while (1) {
+        if (sensor_cache_get(&sensor_cache, &lectura, &edad_ms) == ESP_OK) {
+            ESP_LOGI(TAG, "Telemetría: %.1f C, %.1f %% (hace %" PRIu32 " ms)",
+                     lectura.temperature, lectura.humidity, edad_ms);
+        }
+        sensor_cache_log_stats(&sensor_cache);
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS));
+    }
+}
 
 /**
  * @brief Inicializa los periféricos necesarios
@@ -107,41 +322,51 @@ void app_main()
     // Inicializar hardware
     init_hardware();
     
-    // Inicializar estructura del sensor DHT11
-    dht11_t dht11_sensor = {
-        .dht11_pin = CONFIG_DHT11_PIN,
-        .temperature = 0,
-        .humidity = 0
+    // La captura de la trama se hace por hardware; la CPU queda libre durante la lectura
+    esp_err_t ret = iniciar_sensor();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error al inicializar el lector del DHT11: %s",
+                esp_err_to_name(ret));
+        vTaskDelay(portMAX_DELAY);
+    }
+
+#if FILTER_BENCHMARK
+    medir_filtros();
+#endif
+    iniciar_filtros();
+
+    // Solo la tarea de la caché lee el sensor; pantalla y telemetría consultan la caché
+    sensor_cache_config_t cache_config = {
+        .read = leer_sensor_filtrado,
+        .read_ctx = NULL,
+        .min_interval_ms = CACHE_MIN_INTERVAL_MS,
+        .max_age_ms = CACHE_MAX_AGE_MS,
     };
-    
-    // Variables para almacenar lecturas previas
-    static float prev_temp = INVALID_TEMP_HUM;
-    static float prev_hum = INVALID_TEMP_HUM;
+    ESP_ERROR_CHECK(sensor_cache_init(&sensor_cache, cache_config));
+    xTaskCreate(tarea_telemetria, "telemetria", 3072, NULL, 4, NULL);
     
     ESP_LOGI(TAG, "Iniciando bucle principal...");
     
     // Bucle principal
     while (1) {
-        // Leer valores del sensor DHT11
-        if (dht11_read(&dht11_sensor, CONFIG_CONNECTION_TIMEOUT) == 0) {
-            // Lectura exitosa
-            float curr_temp = dht11_sensor.temperature;
-            float curr_hum = dht11_sensor.humidity;
+        // Consultar la última muestra del sensor DHT11 (no bloquea)
+        dht_reading_t lectura;
+        uint32_t edad_ms;
+        if (sensor_cache_get(&sensor_cache, &lectura, &edad_ms) == ESP_OK &&
+            edad_ms < SAMPLE_EXPIRED_MS) {
+            // Muestra reciente disponible: redibujar solo si alguna magnitud cambió lo suficiente
+            sensor_fixed_t temp, hum;
+            sensor_filter_result_t r_temp = sensor_filter_process(&cambio_temp,
+                    SENSOR_FIXED_FROM_FLOAT(lectura.temperature), &temp);
+            sensor_filter_result_t r_hum = sensor_filter_process(&cambio_hum,
+                    SENSOR_FIXED_FROM_FLOAT(lectura.humidity), &hum);
             
-            // Verificar si los valores son válidos y han cambiado
-            if ((curr_temp != prev_temp || curr_hum != prev_hum) &&
-                curr_temp >= 0 && curr_temp <= 50 &&  // Rango típico DHT11
-                curr_hum >= 20 && curr_hum <= 90) {    // Rango típico DHT11
-                
+            if (r_temp == SENSOR_FILTER_PASS || r_hum == SENSOR_FILTER_PASS) {
                 // Actualizar pantalla con los nuevos valores
-                update_display(curr_temp, curr_hum);
-                
-                // Guardar valores actuales como previos
-                prev_temp = curr_temp;
-                prev_hum = curr_hum;
+                update_display(SENSOR_FIXED_TO_FLOAT(temp), SENSOR_FIXED_TO_FLOAT(hum));
             }
         } else {
-            // Error en la lectura
+            // Sin muestras recientes en la caché
             ESP_LOGW(TAG, "Error al leer el sensor DHT11");
             
             // Mostrar mensaje de error en la pantalla
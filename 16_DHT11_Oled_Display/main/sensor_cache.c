@@ -0,0 +1,138 @@
+#include "sensor_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "SENSOR_CACHE";
+
+static void sensor_cache_publish(sensor_cache_t *cache, const dht_reading_t *reading, int64_t timestamp_us)
+{
+    portENTER_CRITICAL(&cache->publish_lock);
+
+    // Odd sequence: readers that start now will retry
+    atomic_fetch_add_explicit(&cache->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    cache->reading = *reading;
+    cache->timestamp_us = timestamp_us;
+    cache->valid = true;
+
+    atomic_fetch_add_explicit(&cache->seq, 1, memory_order_release);
+
+    portEXIT_CRITICAL(&cache->publish_lock);
+}
+
+static void sensor_cache_task(void *arg)
+{
+    sensor_cache_t *cache = (sensor_cache_t *)arg;
+    int64_t min_interval_us = (int64_t)cache->config.min_interval_ms * 1000;
+    int64_t last_read_us = -min_interval_us;
+    dht_reading_t reading;
+
+    while (1)
+    {
+        xSemaphoreTake(cache->refresh, portMAX_DELAY);
+
+        // Enforce the minimum interval here, so only this task ever waits for the sensor
+        int64_t wait_us = last_read_us + min_interval_us - esp_timer_get_time();
+        if (wait_us > 0) vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000) + 1);
+
+        atomic_store(&cache->refresh_pending, false);
+        last_read_us = esp_timer_get_time();
+        atomic_fetch_add(&cache->stats.reads, 1);
+
+        esp_err_t ret = cache->config.read(cache->config.read_ctx, &reading);
+        cache->last_error = ret;
+        if (ret == ESP_OK)
+        {
+            sensor_cache_publish(cache, &reading, esp_timer_get_time());
+        }
+        else
+        {
+            atomic_fetch_add(&cache->stats.failures, 1);
+            ESP_LOGW(TAG, "Read failed: %s, keeping the previous sample", esp_err_to_name(ret));
+        }
+    }
+}
+
+esp_err_t sensor_cache_init(sensor_cache_t *cache, sensor_cache_config_t config)
+{
+    if (cache == NULL || config.read == NULL) return ESP_ERR_INVALID_ARG;
+
+    cache->config = config;
+    cache->valid = false;
+    cache->timestamp_us = 0;
+    cache->last_error = ESP_OK;
+    portMUX_INITIALIZE(&cache->publish_lock);
+    atomic_init(&cache->seq, 0);
+    atomic_init(&cache->refresh_pending, false);
+    atomic_init(&cache->stats.gets, 0);
+    atomic_init(&cache->stats.refresh_requests, 0);
+    atomic_init(&cache->stats.reads, 0);
+    atomic_init(&cache->stats.failures, 0);
+    atomic_init(&cache->stats.retries, 0);
+
+    cache->refresh = xSemaphoreCreateBinary();
+    if (cache->refresh == NULL) return ESP_ERR_NO_MEM;
+
+    if (xTaskCreate(sensor_cache_task, "sensor_cache", SENSOR_CACHE_TASK_STACK, cache,
+                    SENSOR_CACHE_TASK_PRIORITY, &cache->task) != pdPASS)
+    {
+        vSemaphoreDelete(cache->refresh);
+        return ESP_ERR_NO_MEM;
+    }
+
+    sensor_cache_request_refresh(cache);
+    return ESP_OK;
+}
+
+void sensor_cache_request_refresh(sensor_cache_t *cache)
+{
+    // Many readers may see the same stale sample; only the first one wakes the task
+    if (!atomic_exchange(&cache->refresh_pending, true))
+    {
+        atomic_fetch_add(&cache->stats.refresh_requests, 1);
+        xSemaphoreGive(cache->refresh);
+    }
+}
+
+esp_err_t sensor_cache_get(sensor_cache_t *cache, dht_reading_t *reading, uint32_t *age_ms)
+{
+    unsigned seq_start;
+    int64_t timestamp_us;
+    bool valid;
+
+    atomic_fetch_add_explicit(&cache->stats.gets, 1, memory_order_relaxed);
+
+    while (1)
+    {
+        seq_start = atomic_load_explicit(&cache->seq, memory_order_acquire);
+        if (seq_start & 1)
+        {
+            atomic_fetch_add_explicit(&cache->stats.retries, 1, memory_order_relaxed);
+            continue;
+        }
+
+        *reading = cache->reading;
+        timestamp_us = cache->timestamp_us;
+        valid = cache->valid;
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&cache->seq, memory_order_relaxed) == seq_start) break;
+        atomic_fetch_add_explicit(&cache->stats.retries, 1, memory_order_relaxed);
+    }
+
+    int64_t age_us = esp_timer_get_time() - timestamp_us;
+    if (!valid || age_us > (int64_t)cache->config.max_age_ms * 1000) sensor_cache_request_refresh(cache);
+
+    if (!valid) return ESP_ERR_NOT_FOUND;
+    if (age_ms) *age_ms = age_us / 1000;
+    return ESP_OK;
+}
+
+void sensor_cache_log_stats(sensor_cache_t *cache)
+{
+    ESP_LOGI(TAG, "gets: %u, refresh requests: %u, reads: %u, failures: %u, reader retries: %u",
+             atomic_load(&cache->stats.gets), atomic_load(&cache->stats.refresh_requests),
+             atomic_load(&cache->stats.reads), atomic_load(&cache->stats.failures),
+             atomic_load(&cache->stats.retries));
+}
@@ -0,0 +1,110 @@
+#ifndef SENSOR_CACHE
+#define SENSOR_CACHE
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "dht_decode.h"
+
+// Stack and priority of the task that refreshes the cache
+#define SENSOR_CACHE_TASK_STACK    3072
+#define SENSOR_CACHE_TASK_PRIORITY 5
+
+/**
+ * @brief Blocking read of the sensor, called only from the refresh task
+ * @param ctx user context given in the configuration
+ * @param reading filled with the new values on success
+*/
+typedef esp_err_t (*sensor_cache_read_fn_t)(void *ctx, dht_reading_t *reading);
+
+/**
+ * Configuration of a sample cache
+ * @var read function reading the sensor
+ * @var read_ctx context passed to read
+ * @var min_interval_ms minimum time between two reads of the sensor (1000 for the DHT11)
+ * @var max_age_ms a sample older than this is stale and the next get triggers a refresh
+*/
+typedef struct
+{
+    sensor_cache_read_fn_t read;
+    void *read_ctx;
+    uint32_t min_interval_ms;
+    uint32_t max_age_ms;
+} sensor_cache_config_t;
+
+/**
+ * Counters of a sample cache
+ * @var gets calls to sensor_cache_get()
+ * @var refresh_requests gets that found the sample stale and woke the refresh task
+ * @var reads reads of the sensor
+ * @var failures reads that failed (the previous sample is kept)
+ * @var retries times a reader raced with the writer and copied the sample again
+*/
+typedef struct
+{
+    atomic_uint gets;
+    atomic_uint refresh_requests;
+    atomic_uint reads;
+    atomic_uint failures;
+    atomic_uint retries;
+} sensor_cache_stats_t;
+
+/**
+ * Latest sample of a sensor shared by any number of readers.
+ *
+ * A single refresh task owns the sensor and publishes each sample under a sequence lock:
+ * the sequence is odd while the sample is being written, and readers copy the sample and
+ * retry if the sequence changed meanwhile. Readers never take a lock and never block.
+ * The write is a short critical section, so a reader spinning on an odd sequence can never
+ * have preempted the writer on its own core.
+*/
+typedef struct
+{
+    sensor_cache_config_t config;
+    TaskHandle_t task;
+    SemaphoreHandle_t refresh;
+    atomic_uint seq;
+    atomic_bool refresh_pending;
+    portMUX_TYPE publish_lock;
+
+    // Protected by seq
+    dht_reading_t reading;
+    int64_t timestamp_us;
+    bool valid;
+
+    esp_err_t last_error;
+    sensor_cache_stats_t stats;
+} sensor_cache_t;
+
+/**
+ * @brief Creates the refresh task and requests the first read
+ * @param cache cache to initialize, must stay valid while the task runs
+ * @param config read function and timing
+*/
+esp_err_t sensor_cache_init(sensor_cache_t *cache, sensor_cache_config_t config);
+
+/**
+ * @brief Copies the latest sample without blocking
+ * @note  If the sample is older than max_age_ms a refresh is requested and the current
+ *        sample is still returned; the new one is available on a later call.
+ * @param cache initialized cache
+ * @param reading filled with the latest sample
+ * @param age_ms if not NULL, filled with the age of the sample in milliseconds
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if no read has succeeded yet
+*/
+esp_err_t sensor_cache_get(sensor_cache_t *cache, dht_reading_t *reading, uint32_t *age_ms);
+
+/**
+ * @brief Asks the refresh task to read the sensor as soon as the minimum interval allows
+*/
+void sensor_cache_request_refresh(sensor_cache_t *cache);
+
+/**
+ * @brief Logs the counters of the cache
+*/
+void sensor_cache_log_stats(sensor_cache_t *cache);
+
+#endif
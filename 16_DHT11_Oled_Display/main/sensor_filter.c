@@ -0,0 +1,217 @@
+#include <string.h>
+#include "sensor_filter.h"
+
+static sensor_filter_stage_t *sensor_filter_add(sensor_filter_t *filter, sensor_filter_stage_type_t type)
+{
+    if (filter->count >= SENSOR_FILTER_MAX_STAGES) return NULL;
+
+    sensor_filter_stage_t *stage = &filter->stages[filter->count++];
+    memset(stage, 0, sizeof(*stage));
+    stage->type = type;
+    return stage;
+}
+
+void sensor_filter_init(sensor_filter_t *filter)
+{
+    memset(filter, 0, sizeof(*filter));
+}
+
+bool sensor_filter_add_range(sensor_filter_t *filter, sensor_fixed_t min, sensor_fixed_t max)
+{
+    sensor_filter_stage_t *stage = sensor_filter_add(filter, SENSOR_FILTER_RANGE);
+    if (stage == NULL) return false;
+    stage->range.min = min;
+    stage->range.max = max;
+    return true;
+}
+
+bool sensor_filter_add_rate(sensor_filter_t *filter, sensor_fixed_t max_delta, uint8_t max_rejects)
+{
+    sensor_filter_stage_t *stage = sensor_filter_add(filter, SENSOR_FILTER_RATE);
+    if (stage == NULL) return false;
+    stage->rate.max_delta = max_delta;
+    stage->rate.max_rejects = max_rejects;
+    return true;
+}
+
+bool sensor_filter_add_median(sensor_filter_t *filter, uint8_t window)
+{
+    if (window == 0 || window > SENSOR_FILTER_MAX_WINDOW || (window & 1) == 0) return false;
+    sensor_filter_stage_t *stage = sensor_filter_add(filter, SENSOR_FILTER_MEDIAN);
+    if (stage == NULL) return false;
+    stage->median.size = window;
+    return true;
+}
+
+bool sensor_filter_add_ema(sensor_filter_t *filter, uint8_t shift)
+{
+    if (shift > 8) return false;
+    sensor_filter_stage_t *stage = sensor_filter_add(filter, SENSOR_FILTER_EMA);
+    if (stage == NULL) return false;
+    stage->ema.shift = shift;
+    return true;
+}
+
+bool sensor_filter_add_hysteresis(sensor_filter_t *filter, sensor_fixed_t threshold)
+{
+    sensor_filter_stage_t *stage = sensor_filter_add(filter, SENSOR_FILTER_HYSTERESIS);
+    if (stage == NULL) return false;
+    stage->hysteresis.threshold = threshold;
+    return true;
+}
+
+// Median of the values in the window; insertion sort on a copy, the window is at most 7
+static sensor_fixed_t median_of(const sensor_fixed_t *values, uint8_t count)
+{
+    sensor_fixed_t sorted[SENSOR_FILTER_MAX_WINDOW];
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sensor_fixed_t v = values[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > v)
+        {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+
+    // Even count while the window fills up: average of the two middle values
+    if ((count & 1) == 0) return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    return sorted[count / 2];
+}
+
+static sensor_filter_result_t stage_process(sensor_filter_stage_t *stage, sensor_fixed_t *value)
+{
+    sensor_fixed_t v = *value;
+
+    switch (stage->type)
+    {
+    case SENSOR_FILTER_RANGE:
+        if (v < stage->range.min || v > stage->range.max) return SENSOR_FILTER_REJECT;
+        break;
+
+    case SENSOR_FILTER_RATE:
+    {
+        sensor_fixed_t delta = v - stage->rate.last;
+        if (delta < 0) delta = -delta;
+        if (stage->primed && delta > stage->rate.max_delta && stage->rate.rejects < stage->rate.max_rejects)
+        {
+            stage->rate.rejects++;
+            return SENSOR_FILTER_REJECT;
+        }
+        stage->rate.rejects = 0;
+        stage->rate.last = v;
+        break;
+    }
+
+    case SENSOR_FILTER_MEDIAN:
+        stage->median.window[stage->median.next] = v;
+        stage->median.next = (stage->median.next + 1) % stage->median.size;
+        if (stage->median.count < stage->median.size) stage->median.count++;
+        *value = median_of(stage->median.window, stage->median.count);
+        break;
+
+    case SENSOR_FILTER_EMA:
+    {
+        int32_t scaled = v * (1 << SENSOR_FILTER_EMA_FRAC_BITS);
+        if (!stage->primed) stage->ema.acc = scaled;
+        else stage->ema.acc += (scaled - stage->ema.acc) / (1 << stage->ema.shift);
+        // Round to nearest, symmetric for negative values
+        int32_t half = 1 << (SENSOR_FILTER_EMA_FRAC_BITS - 1);
+        *value = (stage->ema.acc + (stage->ema.acc < 0 ? -half : half)) / (1 << SENSOR_FILTER_EMA_FRAC_BITS);
+        break;
+    }
+
+    case SENSOR_FILTER_HYSTERESIS:
+    {
+        sensor_fixed_t delta = v - stage->hysteresis.reported;
+        if (delta < 0) delta = -delta;
+        if (stage->primed && delta < stage->hysteresis.threshold)
+        {
+            *value = stage->hysteresis.reported;
+            return SENSOR_FILTER_HOLD;
+        }
+        stage->hysteresis.reported = v;
+        break;
+    }
+    }
+
+    stage->primed = true;
+    return SENSOR_FILTER_PASS;
+}
+
+sensor_filter_result_t sensor_filter_process(sensor_filter_t *filter, sensor_fixed_t in, sensor_fixed_t *out)
+{
+    sensor_fixed_t value = in;
+
+    for (uint8_t i = 0; i < filter->count; i++)
+    {
+        sensor_filter_result_t result = stage_process(&filter->stages[i], &value);
+        if (result == SENSOR_FILTER_REJECT)
+        {
+            filter->rejected++;
+            return result;
+        }
+        if (result == SENSOR_FILTER_HOLD)
+        {
+            filter->held++;
+            *out = value;
+            return result;
+        }
+    }
+
+    *out = value;
+    return SENSOR_FILTER_PASS;
+}
+
+sensor_filter_result_t sensor_filter_check(const sensor_filter_t *filter, sensor_fixed_t in)
+{
+    for (uint8_t i = 0; i < filter->count; i++)
+    {
+        const sensor_filter_stage_t *stage = &filter->stages[i];
+
+        if (stage->type == SENSOR_FILTER_RANGE)
+        {
+            if (in < stage->range.min || in > stage->range.max) return SENSOR_FILTER_REJECT;
+        }
+        else if (stage->type == SENSOR_FILTER_RATE)
+        {
+            // Same decision as stage_process(), without counting the rejection
+            sensor_fixed_t delta = in - stage->rate.last;
+            if (delta < 0) delta = -delta;
+            if (stage->primed && delta > stage->rate.max_delta && stage->rate.rejects < stage->rate.max_rejects)
+                return SENSOR_FILTER_REJECT;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return SENSOR_FILTER_PASS;
+}
+
+void sensor_filter_reset(sensor_filter_t *filter)
+{
+    for (uint8_t i = 0; i < filter->count; i++)
+    {
+        sensor_filter_stage_t *stage = &filter->stages[i];
+        sensor_filter_stage_type_t type = stage->type;
+        sensor_filter_stage_t config = *stage;
+
+        memset(stage, 0, sizeof(*stage));
+        stage->type = type;
+        if (type == SENSOR_FILTER_RANGE) stage->range = config.range;
+        else if (type == SENSOR_FILTER_RATE)
+        {
+            stage->rate.max_delta = config.rate.max_delta;
+            stage->rate.max_rejects = config.rate.max_rejects;
+        }
+        else if (type == SENSOR_FILTER_MEDIAN) stage->median.size = config.median.size;
+        else if (type == SENSOR_FILTER_EMA) stage->ema.shift = config.ema.shift;
+        else if (type == SENSOR_FILTER_HYSTERESIS) stage->hysteresis.threshold = config.hysteresis.threshold;
+    }
+    filter->rejected = 0;
+    filter->held = 0;
+}
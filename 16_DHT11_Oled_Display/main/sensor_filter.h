@@ -0,0 +1,127 @@
+#ifndef SENSOR_FILTER
+#define SENSOR_FILTER
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Fixed-point sensor value: hundredths of the unit (2345 = 23.45 C)
+typedef int32_t sensor_fixed_t;
+#define SENSOR_FIXED_SCALE 100
+#define SENSOR_FIXED_FROM_FLOAT(f) ((sensor_fixed_t)((f) * SENSOR_FIXED_SCALE + ((f) < 0 ? -0.5f : 0.5f)))
+#define SENSOR_FIXED_TO_FLOAT(v) ((float)(v) / SENSOR_FIXED_SCALE)
+
+// Maximum number of stages in a pipeline and window of the median stage
+#define SENSOR_FILTER_MAX_STAGES 6
+#define SENSOR_FILTER_MAX_WINDOW 7
+
+// Extra fractional bits kept by the EMA accumulator
+#define SENSOR_FILTER_EMA_FRAC_BITS 8
+
+typedef enum
+{
+    SENSOR_FILTER_PASS,     // Value went through every stage
+    SENSOR_FILTER_REJECT,   // Value dropped as invalid or as an outlier
+    SENSOR_FILTER_HOLD,     // Value did not change enough to be reported
+} sensor_filter_result_t;
+
+typedef enum
+{
+    SENSOR_FILTER_RANGE,
+    SENSOR_FILTER_RATE,
+    SENSOR_FILTER_MEDIAN,
+    SENSOR_FILTER_EMA,
+    SENSOR_FILTER_HYSTERESIS,
+} sensor_filter_stage_type_t;
+
+/**
+ * One stage of a pipeline and its state
+*/
+typedef struct
+{
+    sensor_filter_stage_type_t type;
+    bool primed;                // Stage has seen its first value
+    union
+    {
+        struct { sensor_fixed_t min, max; } range;
+        struct { sensor_fixed_t max_delta, last; uint8_t max_rejects, rejects; } rate;
+        struct { sensor_fixed_t window[SENSOR_FILTER_MAX_WINDOW]; uint8_t size, count, next; } median;
+        struct { int32_t acc; uint8_t shift; } ema;
+        struct { sensor_fixed_t threshold, reported; } hysteresis;
+    };
+} sensor_filter_stage_t;
+
+/**
+ * Chain of stages applied in the order they were added.
+ * Every stage works on integers only, so a sample costs a few hundred cycles without an FPU.
+ * @var stages stages of the pipeline
+ * @var count number of stages
+ * @var rejected values rejected by the range or rate stages
+ * @var held values held by the hysteresis stage
+*/
+typedef struct
+{
+    sensor_filter_stage_t stages[SENSOR_FILTER_MAX_STAGES];
+    uint8_t count;
+    uint32_t rejected;
+    uint32_t held;
+} sensor_filter_t;
+
+/**
+ * @brief Empties the pipeline
+*/
+void sensor_filter_init(sensor_filter_t *filter);
+
+/**
+ * @brief Rejects values outside [min, max] (sensor range or obviously corrupted frames)
+ * @return false if the pipeline is full
+*/
+bool sensor_filter_add_range(sensor_filter_t *filter, sensor_fixed_t min, sensor_fixed_t max);
+
+/**
+ * @brief Rejects values that moved more than max_delta since the last accepted one
+ * @note  After max_rejects consecutive rejections the value is accepted: it is a real step
+ * @return false if the pipeline is full
+*/
+bool sensor_filter_add_rate(sensor_filter_t *filter, sensor_fixed_t max_delta, uint8_t max_rejects);
+
+/**
+ * @brief Rolling median over the last window values (odd, up to SENSOR_FILTER_MAX_WINDOW)
+ * @return false if the pipeline is full or the window is invalid
+*/
+bool sensor_filter_add_median(sensor_filter_t *filter, uint8_t window);
+
+/**
+ * @brief Exponential moving average with alpha = 1 / 2^shift
+ * @return false if the pipeline is full or shift is larger than 8
+*/
+bool sensor_filter_add_ema(sensor_filter_t *filter, uint8_t shift);
+
+/**
+ * @brief Holds the value until it differs from the last reported one by threshold or more
+ * @return false if the pipeline is full
+*/
+bool sensor_filter_add_hysteresis(sensor_filter_t *filter, sensor_fixed_t threshold);
+
+/**
+ * @brief Feeds one sample through the pipeline
+ * @param filter pipeline
+ * @param in new sample
+ * @param out filtered value; on SENSOR_FILTER_HOLD the last reported value, untouched on REJECT
+*/
+sensor_filter_result_t sensor_filter_process(sensor_filter_t *filter, sensor_fixed_t in, sensor_fixed_t *out);
+
+/**
+ * @brief Tells whether the leading range and rate stages would accept a sample, without changing any state
+ * @note  Used when several values of one reading must be accepted or dropped together: check them all,
+ *        then feed them with sensor_filter_process() only if every check passed. Stages after the first
+ *        median, EMA or hysteresis stage are not checked, so put the range and rate stages first.
+ * @return SENSOR_FILTER_REJECT or SENSOR_FILTER_PASS
+*/
+sensor_filter_result_t sensor_filter_check(const sensor_filter_t *filter, sensor_fixed_t in);
+
+/**
+ * @brief Clears the state of every stage, keeping the configuration
+*/
+void sensor_filter_reset(sensor_filter_t *filter);
+
+#endif